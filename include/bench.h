@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace KhaosChess {
+
+// The fixed position set "bench" searches: openings, middlegames,
+// endgames and a few mates, chosen to exercise every part of the search
+extern const std::vector<std::string> BENCH_FENS;
+
+// Defaults for the arguments bench_command leaves out
+constexpr std::int32_t BENCH_DEPTH = 12;
+constexpr std::int32_t BENCH_THREADS = 1;
+constexpr std::size_t BENCH_HASH_MB = 16;
+
+struct BenchResult {
+    std::uint64_t nodes = 0;  // summed over every position and worker
+    std::chrono::milliseconds time{0};
+    std::uint64_t pawn_probes = 0;  // pawn table lookups by the evals
+    std::uint64_t pawn_hits = 0;
+    std::string error;  // why bench did not run; empty when it did
+};
+
+// Fixed-depth search of every BENCH_FENS position from a cleared table and
+// history. Single-threaded, the node total is a signature of the search:
+// it changes only when search or evaluation behaviour does, so two builds
+// that print the same count search identically and their NPS compares
+// speed alone. The thread count and table size are restored afterwards,
+// the table contents are not. A table attached with SharedHash or filled
+// by hashload cannot be put back, so bench refuses to run on one and says
+// why in `error`. Only call it between searches.
+BenchResult bench(std::int32_t depth = BENCH_DEPTH,
+                  std::int32_t threads = BENCH_THREADS,
+                  std::size_t hash_mb = BENCH_HASH_MB);
+
+// Runs bench() and prints the totals: "bench [depth] [threads] [hash]"
+// in the UCI loop and "KhaosChess bench ..." on the command line
+void bench_command(const char* args);
+
+}  // namespace KhaosChess
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+#include "bitboard.h"
+
+namespace KhaosChess {
+// KPK bitbase: whether white, with king and pawn against a lone king, wins.
+// One bit per position with the pawn on files A-D; normalize() maps any
+// KPK position onto that half of the board.
+namespace BitBase {
+constexpr std::uint32_t MAX_INDEX = 2 * 24 * 64 * 64;
+
+// One bit per index, set when white wins
+extern std::uint32_t BITBASE[MAX_INDEX / 32];
+
+// Startup: solves the bitbase, unless the build embeds a pre-solved one
+void init();
+// Solves the bitbase from scratch by retrograde analysis
+void generate();
+
+bool check(Color side, Square w_ksq, Square w_pawn, Square b_ksq);
+void normalize(Color strong_side, Color& side, Square& strong_king,
+               Square& string_pawn, Square& weak_king);
+}  // namespace BitBase
+}  // namespace KhaosChess
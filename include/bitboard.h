@@ -2,6 +2,7 @@
 
 #include <array>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
 #include <vector>
@@ -10,22 +11,57 @@
 #include "defs.h"
 
 namespace KhaosChess {
-constexpr std::uint16_t BISHOP_ATTACKS_SIZE = 512;
-constexpr std::int16_t ROOK_ATTACKS_SIZE = 4096;
+// Slots a slider needs across the board: one per subset of each square's
+// relevant blockers, 2^bits for that square
+constexpr std::size_t slider_table_size(
+    const std::array<std::int8_t, SQUARE_TOTAL>& relevant_bits) {
+    std::size_t size = 0;
+    for (std::int8_t bits : relevant_bits) {
+        size += std::size_t(1) << bits;
+    }
+    return size;
+}
+
+constexpr std::size_t ROOK_ATTACKS_SIZE = slider_table_size(RELEVANT_ROOK_BITS);
+constexpr std::size_t BISHOP_ATTACKS_SIZE =
+    slider_table_size(RELEVANT_BISHOP_BITS);
+constexpr std::size_t SLIDER_ATTACKS_SIZE =
+    ROOK_ATTACKS_SIZE + BISHOP_ATTACKS_SIZE;
 
 // extern void init_sliders_attacks(PieceType py);
 extern void init_pseudo_attacks();
 
-extern BITBOARD bishopAttacks(BITBOARD occ, Square s);
-extern BITBOARD rookAttacks(BITBOARD occ, Square s);
+// Bishop and rook lookups, aimed at the active slider backend's when it is
+// picked, so no lookup has to ask which one it is
+extern BITBOARD (*bishopAttacks)(BITBOARD occ, Square s);
+extern BITBOARD (*rookAttacks)(BITBOARD occ, Square s);
 
 constexpr BITBOARD square_to_BB(Square square) {
     assert(is_square_ok(square));
     return (1ULL << square);
 }
 
+// How slider attacks are indexed: multiply-shift magics work everywhere,
+// BMI2 PEXT is faster on CPUs where it is a single fast instruction
+enum class SliderBackend { MAGIC, PEXT };
+
 namespace Bitboards {
+// Startup: picks the slider backend and computes every table, unless the
+// build embeds them already (KHAOS_EMBED_TABLES)
 void init();
+// Computes every table from scratch, the slider table in the active
+// backend's layout
+void generate();
+
+// Whether this build and this CPU can use PEXT at all
+bool pext_available();
+// Backend the slider tables are currently laid out for
+SliderBackend slider_backend();
+// Switch the slider lookups to another backend, reordering the slider
+// table in place; false when unavailable.
+// Not thread-safe: only call while no search is running.
+bool set_slider_backend(SliderBackend backend);
+const char* slider_backend_name();
 };
 
 // overloads of bitwise operators between bitboard and square for testing
@@ -145,10 +181,11 @@ constexpr BITBOARD neighboring_files[FILE_NB] = {
     FileG_Bits,               // FILE_H
 };
 
-//// define magic bishop attack table [squares][occupancy]
-extern BITBOARD mBishopAttacks[SQUARE_TOTAL][BISHOP_ATTACKS_SIZE];
-//// define magic rook attack table [squares][occupancy]
-extern BITBOARD mRookAttacks[SQUARE_TOTAL][ROOK_ATTACKS_SIZE];
+// Rook then bishop attacks for every square, packed back to back (~840 KB)
+// in the active backend's layout: magic puts each blocker subset at its
+// magic hash, PEXT in enumeration order. Each square's SMagic::attack
+// points at its own 2^bits slots
+extern BITBOARD mSliderAttacks[SLIDER_ATTACKS_SIZE];
 
 // every pseudo attack for the given piece on the given square
 extern BITBOARD pseudo_attacks[PIECE_TYPE_NB][SQUARE_TOTAL];
@@ -170,7 +207,7 @@ extern BITBOARD full_line_bb[SQUARE_TOTAL][SQUARE_TOTAL];
 // extern U64 rook_attacks[];
 
 struct SMagic {
-    BITBOARD* attack;
+    BITBOARD* attack;    // this square's slots in mSliderAttacks
     BITBOARD mask;       // to mask relevant squares of both lines (no outer squares)
     BITBOARD magic;      // magic 64-bit factor
     std::int32_t shift;  // shift relevant bits
@@ -179,7 +216,8 @@ struct SMagic {
 extern SMagic bishop_magic_tbl[SQUARE_TOTAL];
 extern SMagic rook_magic_tbl[SQUARE_TOTAL];
 
-extern void init_magics(PieceType pt, SMagic magics[]);
+extern std::size_t init_magics(PieceType pt, SMagic magics[],
+                               std::size_t offset);
 extern BITBOARD sliding_attacks(PieceType pt, Square s, BITBOARD occ);
 
 // distance functions return the distance between x and y
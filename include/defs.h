@@ -320,6 +320,71 @@ constexpr std::int32_t MAX_PHASE_SCORE = 24;
 
 typedef std::int32_t Value;  // 32 bit
 
+struct Score {
+    Value mg;  // Middlegame score
+    Value eg;  // Endgame score
+
+    constexpr Score() : mg(0), eg(0) {
+    }
+    constexpr Score(Value mg, Value eg) : mg(mg), eg(eg) {
+    }
+    constexpr Score(Value v) : mg(v), eg(v) {
+    }
+    Score(const Score& other) = default;
+    Score(Score&& other) = default;
+
+    constexpr Score& operator=(const Score& other) = default;
+    constexpr Score& operator=(Score&& other) = default;
+
+    // Addition operators
+    constexpr Score operator+(const Score& other) const {
+        return Score(mg + other.mg, eg + other.eg);
+    }
+    constexpr Score& operator+=(const Score& other) {
+        mg += other.mg;
+        eg += other.eg;
+        return *this;
+    }
+
+    // Subtraction operators
+    constexpr Score operator-(const Score& other) const {
+        return Score(mg - other.mg, eg - other.eg);
+    }
+    constexpr Score operator-() const {
+        return Score(-mg, -eg);
+    }
+    constexpr Score& operator-=(const Score& other) {
+        mg -= other.mg;
+        eg -= other.eg;
+        return *this;
+    }
+
+    // Multiplication operators
+    constexpr Score operator*(const Score& other) const {
+        return Score(mg * other.mg, eg * other.eg);
+    }
+
+    // Division operators
+    constexpr Score operator/(const Score& other) const {
+        return Score(mg / other.mg, eg / other.eg);
+    }
+
+    constexpr bool operator==(const Score& other) const {
+        return mg == other.mg && eg == other.eg;
+    }
+    constexpr bool operator!=(const Score& other) const {
+        return !(*this == other);
+    }
+};
+
+constexpr Score operator*(const Value& value, const Score& other) {
+    return Score(other.mg * value, other.eg * value);
+}
+
+// Game phase weight of each piece type: the sum over the board is 24 in
+// the opening and falls towards 0 as pieces come off
+constexpr Value PIECE_WEIGHTS[PIECE_TYPE_NB] = {0, 0, 1, 1, 2, 4, 0};
+
 constexpr Value VALUE_ZERO = 0;
 constexpr Value VALUE_DRAW = 0;
 constexpr Value VALUE_POSITIVE_DRAW = 10;
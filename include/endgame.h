@@ -3,17 +3,11 @@
 #include <array>
 #include <functional>
 
+#include "bitbase.h"
 #include "position.h"
 #include "score.h"
 
 namespace KhaosChess {
-namespace BitBase {
-void init();
-bool check(Color side, Square w_ksq, Square w_pawn, Square b_ksq);
-void normalize(Color strong_side, Color& side, Square& strong_king,
-               Square& string_pawn, Square& weak_king);
-}  // namespace BitBase
-
 namespace Endgames {
 class EndgameBase {
    public:
@@ -40,6 +34,12 @@ class EndgameBase {
 };
 
 void init();
+
+// The evaluator that applies to pos, or nullptr. Which one applies depends
+// on the material alone, so the material table can cache it
+const EndgameBase* find(const Position& pos);
+
+// find(pos)'s score, VALUE_NONE when no evaluator applies
 Value score(const Position& pos);
 
 }  // namespace Endgames
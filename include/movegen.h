@@ -10,11 +10,12 @@ namespace KhaosChess {
 class Position;
 
 enum GenerationTypes {
-    GT_CAPTURE,  // Capturing a piece
-    GT_QUIET,    // No captures nor promotions
-    GT_EVADE,    // Evade (escape or block) a check
-    GT_ALL,      // Quiet and capture moves
-    GT_LEGAL     // Only legal moves
+    GT_CAPTURE,        // Capturing a piece
+    GT_QUIET,          // No captures nor promotions
+    GT_EVADE,          // Evade (escape or block) a check
+    GT_ALL,            // Quiet and capture moves
+    GT_LEGAL,          // Only legal moves
+    GT_LEGAL_CAPTURE   // Legal captures and promotions, not in check
 };
 
 struct ScoredMoves : public Move {
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+
+#include "defs.h"
+#include "move.h"
+#include "movegen.h"
+#include "position.h"
+
+namespace KhaosChess {
+// Bounds the gravity updates keep the quiet-ordering tables within
+constexpr std::int32_t HISTORY_MAX = 16'000;
+constexpr std::int32_t CONTINUATION_HISTORY_MAX = 16'000;
+
+// Side-to-move slice of the butterfly history, indexed [from][to]
+using HistoryTable = std::int32_t[SQUARE_TOTAL][SQUARE_TOTAL];
+// Continuation history for one previous move, indexed [piece][to]
+using ContinuationTable = std::int16_t[PIECE_NB][SQUARE_TOTAL];
+
+// Hands out a node's legal moves best-first, one per call, generating each
+// group only once the one before it is used up. Most nodes cut off on the
+// TT move or the first capture, so they never generate or score quiets.
+//
+// Main search order: TT move, winning captures and promotions (MVV-LVA,
+// SEE checked only when a capture is reached), killers, countermove,
+// quiets by history, then the losing captures. In check every evasion is
+// scored up front instead, in the same tiers.
+class MovePicker {
+   public:
+    // Main search. killers points at the ply's two killer slots;
+    // continuation may be null when there is no previous move.
+    MovePicker(const Position& pos, Move tt_move, const Move* killers,
+               Move countermove, const HistoryTable& history,
+               const ContinuationTable* continuation);
+
+    // Quiescence: captures and promotions in MVV-LVA order, or every
+    // evasion when in check
+    MovePicker(const Position& pos, Move tt_move);
+
+    // The next legal move, or Move::invalid_move() once none are left
+    Move next_move();
+
+   private:
+    enum Stage : std::int8_t {
+        MAIN_TT,
+        CAPTURE_INIT,
+        GOOD_CAPTURE,
+        KILLER_PRIMARY,
+        KILLER_SECONDARY,
+        COUNTERMOVE,
+        QUIET_INIT,
+        QUIET,
+        BAD_CAPTURE,
+
+        EVASION_TT,
+        EVASION_INIT,
+        EVASION,
+
+        QSEARCH_TT,
+        QCAPTURE_INIT,
+        QCAPTURE,
+
+        DONE
+    };
+
+    bool is_capture(Move m) const;
+    bool is_legal(Move m) const;
+    bool is_valid_quiet(Move m) const;
+    bool is_refutation(Move m) const;
+
+    std::int32_t capture_score(Move m) const;
+    std::int32_t quiet_score(Move m) const;
+    void score_captures();
+    void score_quiets();
+    void score_evasions();
+    ScoredMoves* pick_best();
+
+    const Position& pos;
+    Stage stage;
+
+    Move tt_move;
+    Move refutations[3];  // killers then countermove, invalid once rejected
+    const HistoryTable* history;
+    const ContinuationTable* continuation;
+
+    BITBOARD pinned;
+    Square ksq;
+
+    // Moves live in one buffer: losing captures are parked at the front
+    // while the winning ones are handed out, and quiets are generated
+    // after them
+    ScoredMoves* cur;
+    ScoredMoves* end_moves;
+    ScoredMoves* end_bad_captures;
+    ScoredMoves moves[MAX_MOVES];
+};
+}  // namespace KhaosChess
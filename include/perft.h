@@ -1,6 +1,8 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <string>
@@ -11,6 +13,8 @@
 #include "position.h"
 
 namespace KhaosChess {
+// Reference perft: makes every move down to depth 0. Slow but simple; the
+// fast perft below is checked against it
 inline std::uint64_t perft_driver(Position& pos, std::int32_t depth) {
     if (depth == 0) {
         return 1ULL;
@@ -32,33 +36,23 @@ inline std::uint64_t perft_driver(Position& pos, std::int32_t depth) {
     return nodes;
 }
 
-inline void perft_debug(Position& pos, std::int32_t depth) {
-    BITBOARD nodes = 0;
-    auto start_time = std::chrono::high_resolution_clock::now();
-
-    for (const auto& m : MoveList<GT_LEGAL>(pos)) {
-        MoveInfo move_info;
-        pos.do_move(m, move_info);
-
-        BITBOARD count = perft_driver(pos, depth - 1);
-
-        pos.undo_move(m);
-
-        std::cout << m.uci_move() << ": " << count << std::endl;
-
-        nodes += count;
-    }
-
-    auto end_time = std::chrono::high_resolution_clock::now();
-
-    std::cout << "\nNodes: " << nodes;
-    std::cout << "\nDepth: " << depth;
-    std::cout << "\nTime: "
-              << std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
-                                                                       start_time)
-                     .count()
-              << "ms\n";
-}
+// Switches for the fast perft. Each one can be turned off, down to a walk
+// that counts exactly like perft_driver
+struct PerftOptions {
+    bool bulk = true;           // count the last ply's moves without making them
+    std::size_t hash_mb = 0;    // perft hash size in MB, 0 for none
+    std::int32_t threads = 1;   // root moves shared among this many workers
+};
+
+// Leaf count at `depth`. With threads > 1 the Threads pool is resized to
+// that count; only call it between searches
+std::uint64_t perft(Position& pos, std::int32_t depth,
+                    const PerftOptions& options = PerftOptions{});
+
+// Divide: perft with one "move: count" line per root move, then the total,
+// depth, time and speed. Backs "go perft" and tools/perft.cpp
+std::uint64_t perft_debug(Position& pos, std::int32_t depth,
+                          const PerftOptions& options = PerftOptions{});
 
 inline void print_perft_table(Position& pos) {
     std::int32_t depth;
@@ -21,6 +21,16 @@ extern const std::string START_FEN;
 extern const std::string TEST_FEN;
 extern const std::string TEST_ATTACKS_FEN;
 
+// Material + PSQT of every piece on every square, White's pieces positive
+// and Black's negative, so the Position can keep their sum as pieces move.
+// Built from MATERIAL_SCORES and PSQT by PSQ::init() (score.cpp)
+namespace PSQ {
+extern Score table[PIECE_NB][SQUARE_TOTAL];
+
+// Startup, and again after MATERIAL_SCORES or PSQT change
+void init();
+}  // namespace PSQ
+
 /*
         binary representation of castling rights
 
@@ -53,6 +63,18 @@ struct MoveInfo {
     CastlingRights castling_rights;
     Square en_passant;
     PLY_TYPE fifty_move;  // halfmove clock
+
+    // King lines, per king: that side's pieces shielding it from an enemy
+    // slider, the squares enemy pieces would check it from, and (indexed by
+    // the slider's color) the sliders pinning a piece to the enemy king.
+    // Carried over from the previous move and only redone for a king the
+    // move touches, see Position::do_move
+    BITBOARD king_blockers[BOTH];
+    BITBOARD check_squares[BOTH][PIECE_TYPE_NB];
+    BITBOARD pinners[BOTH];
+
+    BITBOARD pawn_key;  // Zobrist hash of the pawns alone, for the pawn table
+
     Piece captured_piece;
     BITBOARD key;  // Zobrist hash of the position after the move
 
@@ -91,6 +113,25 @@ class Position {
     BITBOARD key() const {
         return move_info->key;
     }
+    BITBOARD pawn_key() const {
+        return move_info->pawn_key;
+    }
+
+    // Material + PSQT of the whole board, White minus Black, kept up to
+    // date by place_piece, remove_piece and move_piece
+    Score psq_score() const {
+        return psq;
+    }
+
+    // Every piece count, kings included, in the PCV layout. Kept up to date
+    // like psq_score() and never 0, so it keys the material table
+    PCV material_key() const {
+        return material;
+    }
+
+    // Key the position would have after m, without making it; lets the
+    // search prefetch the child's TT cluster ahead of do_move
+    BITBOARD key_after(Move m) const;
 
     Square ep_square() const {
         return move_info->en_passant;
@@ -128,14 +169,15 @@ class Position {
     inline BITBOARD get_attacks_by(Color c) const;
     inline BITBOARD get_attacked_squares(Color side) const;
     inline BITBOARD get_checked_squares(PieceType pt) const;
+    // Squares from which a pt of the side to move would check the other king
     inline BITBOARD get_threats(PieceType pt) const {
-        return threats[pt];
+        return move_info->check_squares[~side][pt];
     }
     inline BITBOARD get_king_blockers(Color c) const {
-        return blocking_pieces[c];
+        return move_info->king_blockers[c];
     }
     inline BITBOARD get_pinners(Color c) const {
-        return pinning_pieces[c];
+        return move_info->pinners[c];
     }
 
     // Booleans
@@ -148,6 +190,9 @@ class Position {
     }
     bool is_castling_interrupted(CastlingRights cr) const;
     bool is_legal(Move m) const;
+    // Whether m could have come out of the move generator here; vets moves
+    // from other positions (TT move, killers) before is_legal() is asked
+    bool is_pseudo_legal(Move m) const;
     bool is_square_attacked(Square s) const;
     bool is_square_attacked(Square s, Color c) const;
     bool is_draw() const;
@@ -184,7 +229,7 @@ class Position {
     void do_null_move(MoveInfo& new_info);
     void undo_null_move();
 
-    void update_blocks_and_pins(Color c);
+    void update_king_lines(Color c);
     void remove_piece(Square s);
     void place_piece(Piece p, Square s);
     void calculate_threats();
@@ -212,15 +257,16 @@ class Position {
     BITBOARD get_least_valuable_piece(BITBOARD attacks, Color by_side,
                                       PieceType& pt) const;
     BITBOARD compute_key() const;
+    BITBOARD compute_pawn_key() const;
+    PCV compute_pcv() const;
+    void compute_king_lines(Color c, MoveInfo& info) const;
+    bool king_lines_ok() const;
 
     // Data
     BITBOARD occupancies[BOTH + 1]{};             // All pieces of the side to move
     BITBOARD type[PIECE_TYPE_NB]{};               // All the piece types
     BITBOARD castling_path[CASTLING_RIGHT_NB]{};  // Castling path depending on
                                                   // the castling side
-    BITBOARD threats[PIECE_TYPE_NB]{};            // Piece type threads
-    BITBOARD pinning_pieces[BOTH]{};              // Pieces that are pinning
-    BITBOARD blocking_pieces[BOTH]{};             // Pieces that are blocking
 
     Piece piece_board[SQUARE_TOTAL]{};  // Board of pieces
 
@@ -232,17 +278,17 @@ class Position {
 
     std::int32_t piece_count[PIECE_NB]{};  // Piece count
 
+    Score psq{};           // Sum of PSQ::table over the pieces
+    std::int32_t phase{};  // Sum of PIECE_WEIGHTS over the pieces
+    PCV material{};        // Piece counts, see material_key()
+
     // State info
     MoveInfo* move_info{};
 };
 
 // Calculate game phase (0-24, where 24 is opening, 0 is endgame)
 inline std::int32_t Position::game_phase() const {
-    return std::min(MAX_PHASE_SCORE,
-                    count<KNIGHT>(WHITE) + count<KNIGHT>(BLACK) +
-                        count<BISHOP>(WHITE) + count<BISHOP>(BLACK) +
-                        2 * (count<ROOK>(WHITE) + count<ROOK>(BLACK)) +
-                        4 * (count<QUEEN>(WHITE) + count<QUEEN>(BLACK)));
+    return std::min(MAX_PHASE_SCORE, phase);
 }
 
 template <PieceType pt>
@@ -260,12 +306,10 @@ inline std::int32_t Position::count(Color c, PieceType pt,
     return count(c, pt) + count(c, pts...);
 }
 
+// The material key without the kings
 inline PCV Position::get_pcv() const {
-    return encode_pcv(count<PAWN>(WHITE), count<KNIGHT>(WHITE),
-                      count<BISHOP>(WHITE), count<ROOK>(WHITE),
-                      count<QUEEN>(WHITE), count<PAWN>(BLACK),
-                      count<KNIGHT>(BLACK), count<BISHOP>(BLACK),
-                      count<ROOK>(BLACK), count<QUEEN>(BLACK));
+    return material & ~(PCV(0xF) << (4 * WHITE_KING) |
+                        PCV(0xF) << (4 * BLACK_KING));
 }
 
 // Is square attacked by OPPONENT
@@ -345,6 +389,10 @@ inline void Position::place_piece(Piece p, Square s) {
 
     piece_count[p]++;
     piece_count[get_piece(get_piece_color(p), ALL_PIECES)]++;
+
+    psq += PSQ::table[p][s];
+    phase += PIECE_WEIGHTS[type_of_piece(p)];
+    material += PCV(1) << (4 * p);
 }
 
 inline void Position::remove_piece(Square s) {
@@ -361,6 +409,10 @@ inline void Position::remove_piece(Square s) {
     // Update piece counts
     piece_count[p]--;
     piece_count[get_piece(get_piece_color(p), ALL_PIECES)]--;
+
+    psq -= PSQ::table[p][s];
+    phase -= PIECE_WEIGHTS[type_of_piece(p)];
+    material -= PCV(1) << (4 * p);
 }
 
 inline void Position::move_piece(Square source, Square target) {
@@ -375,6 +427,8 @@ inline void Position::move_piece(Square source, Square target) {
 
     piece_board[source] = NO_PIECE;
     piece_board[target] = p;
+
+    psq += PSQ::table[p][target] - PSQ::table[p][source];
 }
 
 inline bool Position::is_castling_interrupted(CastlingRights cr) const {
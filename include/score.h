@@ -1,7 +1,9 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <iomanip>
+#include <vector>
 
 #include "consts.h"
 #include "defs.h"
@@ -10,60 +12,6 @@
 #include "position.h"
 
 namespace KhaosChess {
-struct Score {
-    Value mg;  // Middlegame score
-    Value eg;  // Endgame score
-
-    constexpr Score() : mg(0), eg(0) {
-    }
-    constexpr Score(Value mg, Value eg) : mg(mg), eg(eg) {
-    }
-    constexpr Score(Value v) : mg(v), eg(v) {
-    }
-    Score(const Score& other) = default;
-    Score(Score&& other) = default;
-
-    constexpr Score& operator=(const Score& other) = default;
-    constexpr Score& operator=(Score&& other) = default;
-
-    // Addition operators
-    constexpr Score operator+(const Score& other) const {
-        return Score(mg + other.mg, eg + other.eg);
-    }
-    constexpr Score& operator+=(const Score& other) {
-        mg += other.mg;
-        eg += other.eg;
-        return *this;
-    }
-
-    // Subtraction operators
-    constexpr Score operator-(const Score& other) const {
-        return Score(mg - other.mg, eg - other.eg);
-    }
-    constexpr Score operator-() const {
-        return Score(-mg, -eg);
-    }
-    constexpr Score& operator-=(const Score& other) {
-        mg -= other.mg;
-        eg -= other.eg;
-        return *this;
-    }
-
-    // Multiplication operators
-    constexpr Score operator*(const Score& other) const {
-        return Score(mg * other.mg, eg * other.eg);
-    }
-
-    // Division operators
-    constexpr Score operator/(const Score& other) const {
-        return Score(mg / other.mg, eg / other.eg);
-    }
-};
-
-constexpr Score operator*(const Value& value, const Score& other) {
-    return Score(other.mg * value, other.eg * value);
-}
-
 inline std::ostream& operator<<(std::ostream& os, Score s) {
     return os << std::setw(6) << std::setfill(' ') << s.mg << " " << std::setw(6)
               << std::setfill(' ') << s.eg << " ";
@@ -290,8 +238,6 @@ inline KingSafety KING_SAFETY_SCORES;
 
 inline Value TEMPO = 93;
 
-const Value PIECE_WEIGHTS[PIECE_TYPE_NB] = {0, 0, 1, 1, 2, 4, 0};
-
 // 2 * ((2 * knights + 2 * bishops + 2 * rooks) + 1 * queen)
 // double the number of knights, bishops, rooks and queens for a side
 const Value MAX_PIECE_WEIGHTS =
@@ -307,8 +253,18 @@ constexpr Value VALUE_KNOWN_WIN =
 constexpr bool TEMPO_ENABLED = true;
 constexpr bool PSQT_ENABLED = true;
 
+// The full eval reads material + PSQT from Position::psq_score(), which
+// PSQ::init() fixes to the weights of the moment. Anything that changes
+// MATERIAL_SCORES or PSQT under live positions, like the tuner, clears this
+// and the eval sums them from the board and the current weights instead
+inline bool INCREMENTAL_PSQ = true;
+
 class Position;
 
+namespace Endgames {
+class EndgameBase;
+}
+
 enum ScoreComponent : uint8_t {
     SC_MATERIAL,            // The material scores
     SC_MOBILITY,            // The mobility scores
@@ -321,9 +277,73 @@ enum ScoreComponent : uint8_t {
 template <ScoreComponent>
 Score total_scores(const Position& pos);
 
+// Everything the eval derives from the pawns alone: the pawn structure
+// terms of the full eval per side (their material and PSQT are in the
+// Position's running sum), and bitboards other terms can read instead of
+// rebuilding them
+struct PawnEntry {
+    BITBOARD key = 0;
+    Score scores[BOTH];
+    BITBOARD passed[BOTH] = {};
+    BITBOARD attacks[BOTH] = {};
+};
+
+// Per-thread cache of PawnEntry, indexed and verified by the pawn key. The
+// pawns change on few of the moves a search makes, so most evals find
+// their pawn terms here. Always-replace: an entry costs one score_pawns
+// pass to rebuild.
+class PawnTable {
+   public:
+    static constexpr std::size_t SIZE = 16384;  // entries, a power of two
+
+    PawnTable() : entries(SIZE) {}
+
+    // The entry for pos, computed first if the slot holds another pawn key
+    const PawnEntry& probe(const Position& pos);
+
+    std::uint64_t probes = 0;
+    std::uint64_t hits = 0;
+
+   private:
+    std::vector<PawnEntry> entries;
+};
+
+// Everything the eval derives from the material alone: the endgame
+// evaluator that applies (nullptr for none), the phase weight and the
+// material imbalance terms, White minus Black
+struct MaterialEntry {
+    PCV key = 0;
+    const Endgames::EndgameBase* endgame = nullptr;
+    Value weight = 0;
+    Score imbalance;
+};
+
+// Per-thread cache of MaterialEntry, keyed by Position::material_key().
+// A search meets few material balances, so nearly every eval finds its
+// entry here and skips the scan for an endgame evaluator. The key is the
+// exact piece counts, so a matching key is always the same material.
+class MaterialTable {
+   public:
+    static constexpr std::int32_t BITS = 13;
+    static constexpr std::size_t SIZE = std::size_t(1) << BITS;  // entries
+
+    MaterialTable() : entries(SIZE) {}
+
+    // The entry for pos, computed first if the slot holds other material
+    const MaterialEntry& probe(const Position& pos);
+
+   private:
+    std::vector<MaterialEntry> entries;
+};
+
 template <ScoreComponent T>
 struct Scorer {
-    explicit Scorer() : score(0), weight(0) {};
+    // With a pawn table, SC_ALL takes its pawn terms from there; with a
+    // material table, every component takes its endgame evaluator and
+    // phase weight, and SC_ALL its imbalance terms, from there
+    explicit Scorer(PawnTable* pawns = nullptr,
+                    MaterialTable* materials = nullptr)
+        : score(0), weight(0), pawns(pawns), materials(materials) {};
 
     Value get_score(const Position& pos);
     Value get_weight() {
@@ -335,20 +355,12 @@ struct Scorer {
    private:
     Score score;
     Value weight;
+    PawnTable* pawns;
+    MaterialTable* materials;
 
+    // The Position keeps the sum of PIECE_WEIGHTS as pieces come and go
     Value game_phase_weights(const Position& pos) {
-        Value w = 0;
-
-        w += (pos.count<KNIGHT>(WHITE) + pos.count<KNIGHT>(BLACK)) *
-             PIECE_WEIGHTS[KNIGHT];
-        w += (pos.count<BISHOP>(WHITE) + pos.count<BISHOP>(BLACK)) *
-             PIECE_WEIGHTS[BISHOP];
-        w +=
-            (pos.count<ROOK>(WHITE) + pos.count<ROOK>(BLACK)) * PIECE_WEIGHTS[ROOK];
-        w += (pos.count<QUEEN>(WHITE) + pos.count<QUEEN>(BLACK)) *
-             PIECE_WEIGHTS[QUEEN];
-
-        return std::min(w, MAX_PIECE_WEIGHTS);
+        return std::min(pos.game_phase(), MAX_PIECE_WEIGHTS);
     }
 
     Value combine(const Score& score, const Value& weight);
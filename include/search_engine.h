@@ -10,24 +10,35 @@
 #include "movegen.h"
 #include "position.h"
 #include "score.h"
+#include "tt.h"
 
 namespace KhaosChess {
 struct SearchInfo {
     std::vector<Move> pv;            // Principal variation
     std::uint64_t nodes;             // Number of nodes searched
     std::uint64_t q_nodes;           // Number of quiescence nodes searched
+    std::uint64_t evals;             // Static evals computed
+    std::uint64_t evals_saved;       // Static evals taken from the TT instead
+    std::uint64_t pawn_probes;       // Pawn table lookups by those evals
+    std::uint64_t pawn_hits;         // ... that found their entry
     std::int32_t depth;              // Current search depth
     std::int32_t completed_depth;    // Deepest fully-searched iteration
     Value score;                     // Root score at completed_depth
     std::chrono::milliseconds time;  // Time spent searching
+    std::chrono::microseconds cpu_time;  // CPU time this thread used
     bool stopped;                    // Whether search was stopped early
 
     SearchInfo()
         : nodes(0),
           q_nodes(0),
+          evals(0),
+          evals_saved(0),
+          pawn_probes(0),
+          pawn_hits(0),
           depth(0),
           completed_depth(0),
           score(0),
+          cpu_time(0),
           stopped(false) {}
 };
 
@@ -61,6 +72,13 @@ class SearchEngine {
     // search into a normal timed one by arming the deadline from now.
     static void ponderhit(std::chrono::milliseconds budget);
 
+    // Cap the CPU time summed over every worker of the search; 0 means no
+    // limit. Unlike the deadline it does not run while a worker waits for
+    // a core, so it budgets work done rather than time passed. Arming it
+    // starts the count from zero: a ponder search runs without one, and
+    // ponderhit arms it, so time spent pondering is not charged
+    static void set_cpu_budget(std::chrono::milliseconds budget);
+
     // Print a UCI "info" line for a completed iteration. Static because it uses
     // no per-engine state, so ThreadPool can emit the final line for a voted
     // best thread that is not the reporting (main) worker.
@@ -88,6 +106,17 @@ class SearchEngine {
     // arms it from the UCI thread, so it lives in a static like the stop flag.
     static std::atomic<std::int64_t> deadline_ms;
 
+    // The CPU budget in microseconds (0 = none) and what the workers have
+    // spent of it so far; each worker adds its own usage as it polls.
+    // set_cpu_budget bumps the epoch, and a worker that sees a new one
+    // restarts its mark from now instead of charging what came before
+    static std::atomic<std::int64_t> cpu_budget_us;
+    static std::atomic<std::int64_t> cpu_spent_us;
+    static std::atomic<std::uint32_t> cpu_epoch;
+    std::int64_t cpu_start_us = 0;  // this thread's CPU clock at search start
+    std::int64_t cpu_mark_us = 0;   // ... when last added to cpu_spent_us
+    std::uint32_t cpu_epoch_seen = 0;
+
     // Core search functions
     Value negamax(std::int32_t depth, std::int32_t ply, Value alpha, Value beta,
                   SearchInfo& info, bool can_null = true,
@@ -100,6 +129,7 @@ class SearchEngine {
     int thread_id;  // 0 = main worker (reports, searches every depth)
 
     // Utility functions
+    Value evaluate(bool is_tt_hit, const tt::TTData& tte, SearchInfo& info);
     bool is_time_up();
     bool is_capture(Move move);
     bool null_move_cuts(std::int32_t depth, std::int32_t ply, Value beta,
@@ -107,10 +137,6 @@ class SearchEngine {
     bool should_skip_quiet(std::int32_t depth, std::int32_t moves_searched,
                            Value alpha, Value static_eval);
 
-    void score_moves(ScoredMoves* begin, ScoredMoves* end, std::int32_t ply,
-                     Move tt_move = Move::invalid_move(),
-                     bool score_quiets = true,
-                     Move prev_move = Move::invalid_move());
     void update_quiet_stats(Move move, std::int32_t ply, std::int32_t depth,
                             Move prev_move, Move* searched_quiets,
                             std::int32_t num_quiets);
@@ -147,6 +173,11 @@ class SearchEngine {
     // ply, ending at pv_length[ply]. Copied into SearchInfo at the root.
     Move pv_table[MAX_PLY][MAX_PLY];
     std::int32_t pv_length[MAX_PLY];
+
+    // Pawn terms of the evals this thread makes, cached by pawn key, and
+    // their material terms, cached by material key
+    PawnTable pawn_table;
+    MaterialTable material_table;
 };
 
 }  // namespace KhaosChess
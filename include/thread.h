@@ -3,6 +3,7 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -24,6 +25,7 @@ struct SearchLimits {
     std::chrono::milliseconds max_time{0};   // hard: abort an iteration in flight
     std::chrono::milliseconds soft_time{0};  // soft: don't start a new iteration
     std::uint64_t node_limit = 0;
+    std::chrono::milliseconds cpu_time{0};   // CPU time summed over workers
     std::int32_t depth = 64;
     bool ponder = false;                     // search on the opponent's clock
 };
@@ -47,9 +49,22 @@ class ThreadPool {
 
     SearchInfo run(Position& root, const SearchLimits& limits);
 
+    // Node, eval, pawn table and CPU time counters of the last run() summed
+    // over every worker, with its wall time; run() returns only the voted
+    // thread's own
+    const SearchInfo& totals() const {
+        return totals_;
+    }
+
     // Reset every worker's retained history (called on ucinewgame).
     void clear_history();
 
+    // Run job(index, count) once on every worker and wait for all of them;
+    // used to split bulk work such as zeroing the transposition table.
+    // Only call between searches, never while run() is in flight.
+    using Job = std::function<void(std::size_t, std::size_t)>;
+    void run_on_workers(const Job& job);
+
    private:
     struct Worker {
         std::thread thread;
@@ -58,7 +73,7 @@ class ThreadPool {
         std::unique_ptr<SearchEngine> engine;
         SearchInfo result;
         std::int32_t id = 0;
-        bool searching = false;  // guarded by mtx_
+        bool busy = false;  // searching or running a job; guarded by mtx_
     };
 
     void idle_loop(Worker* w);
@@ -67,11 +82,13 @@ class ThreadPool {
 
     std::vector<std::unique_ptr<Worker>> workers_;  // index 0 is the main worker
     std::int32_t count_ = 1;
+    SearchInfo totals_;
 
     std::mutex mtx_;
     std::condition_variable cv_;       // wakes parked workers to start a search
     std::condition_variable done_cv_;  // a worker signals it has finished
     SearchLimits limits_{};            // params of the current search (read by workers)
+    const Job* job_ = nullptr;         // set by run_on_workers instead of a search
     bool exit_ = false;                // set on shutdown so idle loops return
 };
 
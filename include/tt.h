@@ -1,23 +1,33 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <vector>
+#include <string>
 
 #include "defs.h"
 #include "move.h"
 
 namespace KhaosChess {
+class Position;
+
 namespace tt {
+// F_NONE marks an entry that only carries a static eval: its score is no
+// bound at all and must never produce a cutoff
 enum class Flag : std::uint8_t { F_EXACT = 0,
                                  F_LOWER_BOUND = 1,
-                                 F_UPPER_BOUND = 2 };
+                                 F_UPPER_BOUND = 2,
+                                 F_NONE = 3 };
 
+// A decoded copy of one entry. probe() hands out snapshots rather than
+// pointers into the table, so another thread rewriting the slot while the
+// caller is still reading it cannot change what the caller sees.
 // The bound flag lives in the low 2 bits of gen_flag, the search
 // generation in the high 6 bits, so an entry knows both what its score
 // means and how stale it is.
-struct TTEntry {
-    BITBOARD key = 0;
+struct TTData {
     Value score = 0;
+    Value eval = VALUE_NONE;  // static eval of the position, if stored
     Move move;
     std::int8_t depth = -1;
     std::uint8_t gen_flag = 0;
@@ -30,34 +40,171 @@ struct TTEntry {
     }
 };
 
-static_assert(sizeof(TTEntry) == 16, "TTEntry should pack to 16 bytes");
-
 // Four entries share one cache line; a store evicts the least valuable
-// of the four (shallowest, oldest) instead of whatever the key hashed onto
+// of the four (shallowest, oldest) instead of whatever the key hashed onto.
+//
+// Entry i is split over two words, data[i] and aux[i]:
+//   data (64 bits): move 16 | score 24 | static eval 24
+//   aux  (64 bits): key check 32 | unused 16 | depth + 2 (8) | gen_flag 8
+// Only the low 32 key bits are kept: the cluster index is taken from the
+// high bits of the key, so those are already implied by where the entry
+// lives. An aux word with a zero depth byte is an empty slot.
+//
+// The words are written atomically but not together, so a reader racing a
+// writer can pair one store's aux with another's data. The key check is the
+// key bits XORed with a 32-bit fold of the data word (the Hyatt/Mann
+// lockless scheme on a 32-bit key); a mismatched pair fails the check and
+// reads as a miss. A fifth entry would fit only with a 16-bit check, which
+// lets one probe in 13,000 that should miss through, eval-only entries
+// included
 struct alignas(64) Cluster {
-    TTEntry entry[4];
+    static constexpr int ENTRIES = 4;
+
+    std::atomic<std::uint64_t> data[ENTRIES];
+    std::atomic<std::uint64_t> aux[ENTRIES];
 };
 
 static_assert(sizeof(Cluster) == 64, "Cluster should fill one cache line");
 
+// Counters for sizing Hash. Off by default: every probe and store would
+// otherwise pay for increments on atomics shared by all search threads.
+struct TTStats {
+    std::uint64_t probes = 0;
+    std::uint64_t hits = 0;
+    std::uint64_t collisions = 0;   // misses on a cluster with no free slot
+    std::uint64_t fills = 0;        // stores into an empty slot
+    std::uint64_t updates = 0;      // stores over the same position
+    std::uint64_t evict_age = 0;    // replaced an entry from an older search
+    std::uint64_t evict_depth = 0;  // replaced a shallower current entry
+};
+
 class TranspositionTable {
    public:
+    TranspositionTable() = default;
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Reallocate (contents are lost) and zero the new table. Both resize and
+    // clear split the zeroing across the ThreadPool workers, so they must
+    // not be called while a search is running. clear() leaves a shared
+    // table alone: other processes are still searching it, and entries
+    // from earlier games age out
     void resize(std::size_t mb);
     void clear();
 
-    // Bump the generation; call once at the start of every search
+    // Whether the kernel accepted the request to back the table with
+    // transparent huge pages (Linux only)
+    bool huge_pages() const {
+        return huge_pages_;
+    }
+
+    // Persist the table: a header (format version, Zobrist seed, size,
+    // generation) followed by the raw clusters. load() maps such a file as
+    // the table storage (private copy-on-write, so the file is never
+    // modified) and lets pages fault in as the search touches them; files
+    // from another entry format or Zobrist seed are rejected. Neither may
+    // run during a search. On failure both return false and say why.
+    bool save(const std::string& path, std::string& error) const;
+    bool load(const std::string& path, std::string& error);
+
+    // Whether the table holds a load()ed file, until the next resize
+    bool from_file() const {
+        return loaded;
+    }
+
+    // Back the table with a named POSIX shared-memory segment, so engine
+    // processes on one host share search results with the same lockless
+    // entry discipline the Lazy SMP threads use. The first process creates
+    // the segment with `mb` megabytes; later ones adopt its size. The
+    // search generation is kept in the segment too, and the last process
+    // to detach (resize, load or exit) removes it. POSIX only.
+    bool attach_shared(const std::string& name, std::size_t mb,
+                       std::string& error);
+    bool is_shared() const {
+        return shared != nullptr;
+    }
+
+    // Bump the generation; call once at the start of every search. Also
+    // starts a fresh set of counters when stats are enabled
     void new_search();
 
-    // Returns the matching entry (age refreshed) when found, otherwise
-    // nullptr - callers must check `found` before dereferencing
-    TTEntry* probe(BITBOARD key, bool& found);
+    // Per-mille of entries written or hit during the current search,
+    // sampled from the first 1000 entries (UCI "info hashfull")
+    std::int32_t hashfull() const;
+
+    void set_stats(bool on) {
+        stats_enabled = on;
+    }
+    bool stats_on() const {
+        return stats_enabled;
+    }
+    TTStats stats() const;
+
+    // One "info string" line with hashfull and the counters of the last
+    // search (all zero unless stats are on)
+    void print_stats() const;
+
+    // Returns a snapshot of the matching entry (age refreshed in the table)
+    // and sets `found`; on a miss the snapshot is an empty entry
+    TTData probe(BITBOARD key, bool& found);
+
+    // probe() for the search: a hit whose move is not pseudo-legal in pos,
+    // or whose eval is out of the eval's range, cannot be this position's
+    // and is reported as a miss before its move, bounds or eval get used
+    TTData probe(const Position& pos, bool& found);
+
+    // Start loading the cluster for key into cache. Issued with
+    // Position::key_after before do_move, so the child's probe finds its
+    // cluster already in cache instead of stalling on memory. It only pays
+    // once the table outgrows the caches; one that fits neither gains nor
+    // loses from it
+    void prefetch(BITBOARD key) const {
+        __builtin_prefetch(&clusters[cluster_index(key)]);
+    }
+
+    // Maps a key onto [0, cluster_count) with a multiply-high: the 128-bit
+    // product key * count, shifted down 64 bits. Unlike key & mask this
+    // works for any table size, so Hash gets exactly the requested MB
+    std::size_t cluster_index(BITBOARD key) const {
+        __extension__ using uint128 = unsigned __int128;
+        return static_cast<std::size_t>(
+            (static_cast<uint128>(key) * cluster_count) >> 64);
+    }
+
+    std::size_t size() const {
+        return cluster_count;
+    }
+
+    // A store that updates the same position without a move or an eval
+    // keeps the ones already in the entry
     void store(BITBOARD key, Value score, std::int32_t depth, Flag flag,
-               Move move);
+               Move move, Value eval = VALUE_NONE);
 
    private:
-    std::vector<Cluster> clusters;
-    std::size_t mask = 0;         // index = key & mask, so size must be 2^n
+    struct SharedHeader;
+
+    void release();  // free, unmap or detach from the current storage
+
+    Cluster* clusters = nullptr;  // 2MB-aligned on Linux, see resize()
+    void* mapping = nullptr;      // set when clusters live in a mapped file
+    std::size_t mapping_size = 0;
+    SharedHeader* shared = nullptr;  // start of the mapping when shared
+    std::string shared_name;
+    std::size_t cluster_count = 0;
+    bool huge_pages_ = false;
+    bool loaded = false;  // set by load(), cleared by release()
     std::uint8_t generation = 0;  // 6 bits, wraps around
+
+    bool stats_enabled = false;
+    struct Counters {
+        std::atomic<std::uint64_t> probes{0}, hits{0}, collisions{0},
+            fills{0}, updates{0}, evict_age{0}, evict_depth{0};
+    } counters;
+
+    static void count(std::atomic<std::uint64_t>& c) {
+        c.fetch_add(1, std::memory_order_relaxed);
+    }
 };
 
 extern TranspositionTable TT;
@@ -9,12 +9,20 @@ namespace KhaosChess {
 // castling rights, side to move). Position::do_move updates the key
 // incrementally, exploiting that XOR is its own inverse
 namespace Zobrist {
+// The seed is fixed on purpose: keys must be identical on every run so
+// stored hashes (transposition table, saved TT files, test expectations)
+// stay valid. Saved TT files record it and are rejected if it changes
+constexpr std::uint64_t SEED = 1070372;
+
 extern BITBOARD psq[PIECE_NB][SQUARE_TOTAL];  // piece on square
 extern BITBOARD en_passant[FILE_NB];          // ep file (only file matters)
 extern BITBOARD castling[CASTLING_RIGHT_NB];  // indexed by full rights mask
 extern BITBOARD side;                         // xored when black to move
 
+// Startup: draws the keys, unless the build embeds them already
 void init();
+// Draws every key from SEED
+void generate();
 }  // namespace Zobrist
 
 }  // namespace KhaosChess
@@ -0,0 +1,204 @@
+#include "bitbase.h"
+
+#include <cstring>
+#include <vector>
+
+namespace KhaosChess {
+namespace BitBase {
+enum Result : std::uint8_t { R_INVALID,
+                             R_UNKNOWN,
+                             R_WIN,
+                             R_DRAW };
+
+#if defined(KHAOS_EMBEDDED_TABLES)
+// Solved at build time by tools/tablegen.cpp
+#include "bitbase_tables.inc"
+#else
+std::uint32_t BITBASE[MAX_INDEX / 32];
+#endif
+
+// index bits:
+// 0-5       : white king square [0-63]
+// 6-11      : black king square [0-63]
+// 12        : color             [0-1]
+// 13-14     : pawn file         [0-3] Only to file D
+// 15-17     : pawn rank         [1-6] Without Rank 1 and 8
+std::uint32_t encode_index(Color side, Square w_king, Square w_pawn,
+                           Square b_king) {
+    assert(file_of(w_pawn) <= FILE_D);
+    assert((rank_of(w_pawn) != RANK_1) && (rank_of(w_pawn) != RANK_8));
+
+    // Don't include rank 7 in the index
+    std::uint32_t index =
+        ((w_king << 0) + (b_king << 6) + (side << 12) + (file_of(w_pawn) << 13) +
+         ((rank_of(w_pawn) - RANK_7) << 15));
+
+    assert(index < MAX_INDEX);
+
+    return index;
+}
+
+void parse_index(std::uint32_t index, Color& side, Square& w_king,
+                 Square& w_pawn, Square& b_king) {
+    assert(index < MAX_INDEX);
+
+    w_king = Square(index & 0x3F);
+    b_king = Square((index >> 6) & 0x3F);
+    side = Color((index >> 12) & 0x1);
+    w_pawn = make_square(File((index >> 13) & 0x3),
+                         Rank(((index >> 15) & 0x7) + RANK_7));
+}
+
+bool check(Color side, Square w_ksq, Square w_pawn, Square b_ksq) {
+    std::uint32_t index =
+        encode_index(side, w_ksq, w_pawn, b_ksq);  // get the index
+    return BITBASE[index / 32] &
+           (1 << (index & 0x1F));  // check if the bit is set
+}
+
+Result initial_score(std::uint32_t index) {
+    Color side;
+    Square w_ksq, w_pawn, b_ksq;
+    parse_index(index, side, w_ksq, w_pawn, b_ksq);  // get the index
+
+    bool is_black_in_check = bool(pawn_attacks_bb<WHITE>(w_pawn) & b_ksq);
+
+    // Kings cannot be in neighboring squares
+    // Pawns cannot be in the same squares as the kings
+    // If it's white to move, black cannot be in check
+    if ((distance(w_ksq, b_ksq) <= 1) || (w_ksq == w_pawn) || (b_ksq == w_pawn) ||
+        ((side == WHITE) && is_black_in_check)) {
+        return R_INVALID;
+    }
+
+    BITBOARD black_king_moves =
+        attacks_bb_by<KING>(b_ksq) &      // Get the black king moves
+        ~attacks_bb_by<KING>(w_ksq) &     // Intersect with all the squares
+                                          // except the white king attacks
+        ~pawn_attacks_bb<WHITE>(w_pawn);  // Intersect with all the squares
+                                          // except the white pawn attacks
+
+    // If it's black's turn and there are no legal moves
+    if ((side == BLACK) && !black_king_moves) {
+        return R_DRAW;
+    }
+
+    Square next_psq = w_pawn + UP;
+
+    if ((side == WHITE) && (rank_of(w_pawn) == RANK_7) && (w_ksq != next_psq) &&
+        (b_ksq != next_psq) && bool(black_king_moves & next_psq)) {
+        return R_WIN;
+    }
+
+    // If it's black to move and amongst black king moves is a white pawn
+    // This means that the black king can capture the white pawn
+    if ((side == BLACK) && bool(black_king_moves & w_pawn)) {
+        return R_DRAW;
+    }
+
+    return R_UNKNOWN;
+}
+
+Result update_score(const std::vector<Result>& results, std::uint32_t idx) {
+    Color side;
+    Square w_ksq, w_pawn, b_ksq;
+    parse_index(idx, side, w_ksq, w_pawn, b_ksq);  // get the index
+
+    Result better = (side == WHITE) ? R_WIN : R_DRAW;
+    Result worse = (side == WHITE) ? R_DRAW : R_WIN;
+
+    Square our_ksq = (side == WHITE) ? w_ksq : b_ksq;
+
+    bool is_unknown = false;
+
+    BITBOARD k_moves = attacks_bb_by<KING>(our_ksq);
+    while (k_moves) {
+        Square sq = pop_ls1b(k_moves);
+        std::uint32_t index = encode_index(~side, (side == WHITE) ? sq : w_ksq,
+                                           w_pawn, (side == WHITE) ? b_ksq : sq);
+
+        if (results[index] == better) {
+            return better;
+        }
+
+        is_unknown |= (results[index] == R_UNKNOWN);
+    }
+
+    // If white's side, check pawn moves
+    if ((side == WHITE) && (~Rank7_Bits & w_pawn)) {
+        // single push
+        Square next_psq =
+            w_pawn + UP;  // Next pawn square; - because of Rank enum ordering
+        std::uint32_t index = encode_index(BLACK, w_ksq, next_psq, b_ksq);
+
+        is_unknown |= (results[index] == R_UNKNOWN);
+
+        // double push if pawn is on rank 2
+        if (Rank2_Bits & w_pawn) {
+            next_psq += UP;  // Already pushed once
+            index = encode_index(BLACK, w_ksq, next_psq, b_ksq);
+        }
+
+        if (results[index] == better) {
+            return better;
+        }
+
+        is_unknown |= (results[index] == R_UNKNOWN);
+    }
+
+    return is_unknown ? R_UNKNOWN : worse;
+}
+
+void init() {
+#if !defined(KHAOS_EMBEDDED_TABLES)
+    generate();
+#endif
+}
+
+void generate() {
+    memset(BITBASE, 0, sizeof(BITBASE));
+    std::vector<Result> results(MAX_INDEX, R_UNKNOWN);
+
+    for (std::uint32_t idx = 0; idx < MAX_INDEX; ++idx) {
+        results[idx] = initial_score(idx);
+    }
+
+    bool repeat = true;
+    while (repeat) {
+        repeat = false;
+        for (std::uint32_t idx = 0; idx < MAX_INDEX; ++idx) {
+            if (results[idx] == R_UNKNOWN) {
+                results[idx] = update_score(results, idx);
+                repeat |= (results[idx] != R_UNKNOWN);
+            }
+        }
+    }
+
+    for (std::uint32_t idx = 0; idx < MAX_INDEX; ++idx) {
+        if (results[idx] == R_WIN) {
+            BITBASE[idx / 32] |= (1 << (idx & 0x1F));
+        }
+    }
+}
+
+void normalize(Color strong_side, Color& side, Square& strong_king,
+               Square& strong_pawn, Square& weak_king) {
+    // Flip everything so the pawns are on files A to D
+    if (file_of(strong_pawn) > FILE_D) {
+        strong_king = flip_filewise(strong_king);
+        strong_pawn = flip_filewise(strong_pawn);
+        weak_king = flip_filewise(weak_king);
+    }
+
+    // Flip everything such that the strong side is always white
+    if (strong_side == BLACK) {
+        strong_king = flip_rankwise(strong_king);
+        strong_pawn = flip_rankwise(strong_pawn);
+        weak_king = flip_rankwise(weak_king);
+
+        side = ~side;
+    }
+}
+
+}  // namespace BitBase
+}  // namespace KhaosChess
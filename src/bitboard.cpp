@@ -5,7 +5,21 @@
 #include "defs.h"
 #include "random.h"
 
+// Slider backend, from the KHAOS_SLIDERS CMake option: AUTO picks PEXT at
+// startup when CPUID reports a fast one, PEXT and MAGIC force either.
+// PEXT is emitted as inline asm, so AUTO builds still run on any x86-64.
+#if !defined(SLIDERS_FORCE_MAGIC) && defined(__x86_64__) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define HAS_PEXT
+#elif defined(SLIDERS_FORCE_PEXT)
+#error "PEXT sliders need an x86-64 GCC or Clang build"
+#endif
+
 namespace KhaosChess {
+#if defined(KHAOS_EMBEDDED_TABLES)
+// Computed at build time by tools/tablegen.cpp
+#include "bitboard_tables.inc"
+#else
 // Table measuring the distance between 2 coordinates
 std::int32_t square_distance[SQUARE_TOTAL][SQUARE_TOTAL];
 
@@ -25,16 +39,169 @@ BITBOARD full_line_bb[SQUARE_TOTAL][SQUARE_TOTAL];
 SMagic bishop_magic_tbl[SQUARE_TOTAL];
 SMagic rook_magic_tbl[SQUARE_TOTAL];
 
-BITBOARD mBishopAttacks[SQUARE_TOTAL][BISHOP_ATTACKS_SIZE];  // Bishop attacks
-BITBOARD mRookAttacks[SQUARE_TOTAL][ROOK_ATTACKS_SIZE];      // Rook attacks
+BITBOARD mSliderAttacks[SLIDER_ATTACKS_SIZE];
+#endif
 
 namespace {
 // Masks for king and knight squares
 BITBOARD knight_attacks_mask(const Square& square);
 BITBOARD king_attacks_mask(const Square& square);
+
+// Which layout mSliderAttacks is in, and so which lookups are aimed at it
+#if defined(SLIDERS_FORCE_PEXT)
+constexpr bool use_pext = true;
+constexpr SliderBackend START_BACKEND = SliderBackend::PEXT;
+#elif defined(HAS_PEXT)
+bool use_pext = false;  // chosen in Bitboards::init()
+constexpr SliderBackend START_BACKEND = SliderBackend::MAGIC;
+#else
+constexpr bool use_pext = false;
+constexpr SliderBackend START_BACKEND = SliderBackend::MAGIC;
+#endif
+
+#if defined(HAS_PEXT)
+inline BITBOARD pext(BITBOARD b, BITBOARD mask) {
+    BITBOARD result;
+    __asm__("pextq %2, %1, %0" : "=r"(result) : "r"(b), "rm"(mask));
+    return result;
+}
+
+#endif
+
+#if defined(HAS_PEXT) && !defined(SLIDERS_FORCE_PEXT)
+// BMI2 is there, and PEXT is not the microcoded one of AMD before Zen 3
+bool pext_is_fast() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2") && !__builtin_cpu_is("amdfam15h") &&
+           !__builtin_cpu_is("amdfam17h");
+}
+#endif
+
+// Slot of an occupancy in a square's slider table: the relevant blockers
+// either gathered by PEXT or hashed by the magic multiply
+template <SliderBackend B>
+inline BITBOARD slider_index(const SMagic& sm, BITBOARD occ) {
+#if defined(HAS_PEXT)
+    if constexpr (B == SliderBackend::PEXT) {
+        return pext(occ, sm.mask);
+    }
+#endif
+    return ((occ & sm.mask) * sm.magic) >> (64 - sm.shift);
+}
+
+template <SliderBackend B>
+BITBOARD bishop_attacks(BITBOARD occ, Square sq) {
+    const SMagic& sm = bishop_magic_tbl[sq];
+    return sm.attack[slider_index<B>(sm, occ)];
+}
+
+template <SliderBackend B>
+BITBOARD rook_attacks(BITBOARD occ, Square sq) {
+    const SMagic& sm = rook_magic_tbl[sq];
+    return sm.attack[slider_index<B>(sm, occ)];
+}
+
+// Aims every square's SMagic::attack at its slots in mSliderAttacks
+void point_sliders() {
+    BITBOARD* table = mSliderAttacks;
+
+    for (SMagic* magics : {rook_magic_tbl, bishop_magic_tbl}) {
+        for (Square s = A8; s <= H1; ++s) {
+            magics[s].attack = table;
+            table += std::size_t(1) << magics[s].shift;
+        }
+    }
+}
+
+#if defined(HAS_PEXT) && !defined(SLIDERS_FORCE_PEXT)
+// Moves every square's slots between the two layouts. The n-th subset of
+// the Carry-Rippler walk is the one PEXT numbers n, and the magic layout
+// keeps it at its hash instead
+void relayout_sliders(bool to_pext) {
+    BITBOARD slots[std::size_t(1) << 12];  // a rook in the corner, the most
+
+    for (SMagic* magics : {rook_magic_tbl, bishop_magic_tbl}) {
+        for (Square s = A8; s <= H1; ++s) {
+            const SMagic& sm = magics[s];
+            BITBOARD subset = 0;
+            std::size_t n = 0;
+            do {
+                std::size_t hash =
+                    slider_index<SliderBackend::MAGIC>(sm, subset);
+                slots[to_pext ? n : hash] = sm.attack[to_pext ? hash : n];
+                ++n;
+                subset = (subset - sm.mask) & sm.mask;
+            } while (subset);
+
+            std::copy(slots, slots + n, sm.attack);
+        }
+    }
+}
+#endif
 }  // namespace
 
+BITBOARD (*bishopAttacks)(BITBOARD occ, Square s) =
+    bishop_attacks<START_BACKEND>;
+BITBOARD (*rookAttacks)(BITBOARD occ, Square s) = rook_attacks<START_BACKEND>;
+
+bool Bitboards::pext_available() {
+#if defined(HAS_PEXT)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+
+SliderBackend Bitboards::slider_backend() {
+    return use_pext ? SliderBackend::PEXT : SliderBackend::MAGIC;
+}
+
+const char* Bitboards::slider_backend_name() {
+    return use_pext ? "pext" : "magic";
+}
+
+bool Bitboards::set_slider_backend(SliderBackend backend) {
+    bool want_pext = (backend == SliderBackend::PEXT);
+
+#if defined(HAS_PEXT) && !defined(SLIDERS_FORCE_PEXT)
+    if (want_pext && !pext_available()) {
+        return false;
+    }
+    if (want_pext != use_pext) {
+        relayout_sliders(want_pext);
+        use_pext = want_pext;
+    }
+
+    bishopAttacks = want_pext ? bishop_attacks<SliderBackend::PEXT>
+                              : bishop_attacks<SliderBackend::MAGIC>;
+    rookAttacks = want_pext ? rook_attacks<SliderBackend::PEXT>
+                            : rook_attacks<SliderBackend::MAGIC>;
+#else
+    if (want_pext != use_pext) {
+        return false;  // fixed at build time
+    }
+#endif
+
+    return true;
+}
+
 void Bitboards::init() {
+#if defined(KHAOS_EMBEDDED_TABLES)
+    point_sliders();
+#else
+    generate();
+#endif
+
+    // The slider table starts out magic unless PEXT is forced; it is
+    // reordered once here when the CPU has a fast PEXT
+#if defined(HAS_PEXT) && !defined(SLIDERS_FORCE_PEXT)
+    set_slider_backend(pext_is_fast() ? SliderBackend::PEXT
+                                      : SliderBackend::MAGIC);
+#endif
+}
+
+void Bitboards::generate() {
     // Calculate the square distance
     for (Square x = A8; x <= H1; ++x) {
         for (Square y = A8; y <= H1; ++y) {
@@ -44,8 +211,10 @@ void Bitboards::init() {
     }
 
     // Initialize magic squares
-    init_magics(ROOK, rook_magic_tbl);
-    init_magics(BISHOP, bishop_magic_tbl);
+    std::size_t offset = init_magics(ROOK, rook_magic_tbl, 0);
+    offset = init_magics(BISHOP, bishop_magic_tbl, offset);
+    assert(offset == SLIDER_ATTACKS_SIZE);
+    point_sliders();
 
     // Initialize pseudo attacks
     init_pseudo_attacks();
@@ -90,12 +259,16 @@ void init_pseudo_attacks() {
 }
 
 /// <summary>
-/// Computes all the bishop and rook attacks.
-/// Here is used fancy magic bitboard approach
+/// Computes all the bishop and rook attacks, in the active slider layout.
+/// Here is used fancy magic bitboard approach for the magic layout; the
+/// PEXT layout stores the subsets in enumeration order, which is the order
+/// PEXT numbers them, so no BMI2 is needed to build it
 /// </summary>
 /// <param name="pt">Piece type</param>
 /// <param name="magics">Piece's magic table</param>
-void init_magics(PieceType pt, SMagic magics[]) {
+/// <param name="offset">Where the piece's first square's slots start</param>
+/// <returns>One past the piece's last slot</returns>
+std::size_t init_magics(PieceType pt, SMagic magics[], std::size_t offset) {
     assert((pt == ROOK) || (pt == BISHOP));
 
     BITBOARD subset{}, magic_index{};
@@ -110,15 +283,13 @@ void init_magics(PieceType pt, SMagic magics[]) {
         // Using Carry-Rippler trick to enumerate through all subsets of the
         // mask
         subset = 0;
+        std::size_t pext_index = offset;
         do {
-            magic_index = subset;
-            magic_index *= sm.magic;
-            magic_index >>= (64 - sm.shift);
+            magic_index = (subset * sm.magic) >> (64 - sm.shift);
 
-            (  // pick between rook or bishop tables
-                pt == BISHOP ? mBishopAttacks[s][magic_index]
-                             : mRookAttacks[s][magic_index]) =
+            mSliderAttacks[use_pext ? pext_index : offset + magic_index] =
                 sliding_attacks(pt, s, subset);
+            ++pext_index;
 
             // Steps to derive the expression for enumerating the subsets in the
             // set 'mask' First we set all 'unused' bits of the set OR-ing the
@@ -136,7 +307,11 @@ void init_magics(PieceType pt, SMagic magics[]) {
             // simplify and we should get this expression
             subset = (subset - sm.mask) & sm.mask;
         } while (subset);
+
+        offset += std::size_t(1) << sm.shift;
     }
+
+    return offset;
 }
 
 BITBOARD sliding_attacks(PieceType pt, Square s, BITBOARD occ) {
@@ -163,24 +338,6 @@ BITBOARD sliding_attacks(PieceType pt, Square s, BITBOARD occ) {
     return attacks;
 }
 
-// Calculate the bishop magic attacks
-// here fancy magic bitboard is used
-BITBOARD bishopAttacks(BITBOARD occ, Square sq) {
-    occ &= bishop_magic_tbl[sq].mask;
-    occ *= bishop_magic_tbl[sq].magic;
-    occ >>= (64 - RELEVANT_BISHOP_BITS[sq]);
-
-    return mBishopAttacks[sq][occ];
-}
-
-BITBOARD rookAttacks(BITBOARD occ, Square sq) {
-    occ &= rook_magic_tbl[sq].mask;
-    occ *= rook_magic_tbl[sq].magic;
-    occ >>= (64 - RELEVANT_ROOK_BITS[sq]);
-
-    return mRookAttacks[sq][occ];
-}
-
 namespace {
 BITBOARD knight_attacks_mask(const Square& square) {
     // result attacks
@@ -1,6 +1,8 @@
 ﻿#include <iostream>
 #include <numeric>
+#include <string>
 
+#include "bench.h"
 #include "bitboard.h"
 #include "defs.h"
 #include "endgame.h"
@@ -14,13 +16,24 @@
 
 using namespace KhaosChess;
 
-int main() {
+int main(int argc, char* argv[]) {
     Bitboards::init();
     BitBase::init();
     Endgames::init();
     Zobrist::init();
+    PSQ::init();
     tt::TT.resize(64);
 
+    // "KhaosChess bench [depth] [threads] [hash]": run the benchmark and exit
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        std::string args;
+        for (int i = 2; i < argc; ++i) {
+            args += std::string(" ") + argv[i];
+        }
+        bench_command(args.c_str());
+        return 0;
+    }
+
     // Start the UCI loop
     uci_loop();
 
@@ -201,6 +201,191 @@ ScoredMoves* generate_all_pseudo_legal(const Position& pos,
     return move_list;
 }
 
+// Legal generation: every destination is masked up front, by the check
+// evasion squares and, for a pinned piece, the line through its king, so
+// nothing has to be filtered afterwards. Only en passant and castling, the
+// two moves whose legality depends on more than their own squares, still
+// go through Position::is_legal.
+template <Color Us, GenerationTypes Type>
+ScoredMoves* generate_legal_pawn_moves(const Position& pos,
+                                       ScoredMoves* move_list,
+                                       BITBOARD pawns, BITBOARD target) {
+    constexpr Direction up = pawn_push_direction(Us);
+    constexpr Direction up_right = (Us == WHITE ? UP_RIGHT : DOWN_RIGHT);
+    constexpr Direction up_left = (Us == WHITE ? UP_LEFT : DOWN_LEFT);
+    constexpr BITBOARD promotion_rank = (Us == WHITE ? Rank7_Bits : Rank2_Bits);
+    constexpr BITBOARD third_rank = (Us == WHITE ? Rank3_Bits : Rank6_Bits);
+
+    BITBOARD empty = pos.get_all_empty_squares_bb();
+    BITBOARD enemies = pos.get_opponent_pieces_bb() & target;
+
+    if (Type == GT_LEGAL) {
+        // The double push only needs its first square empty, not in target
+        BITBOARD pushed_pawns = move_to<up>(pawns & ~promotion_rank) & empty;
+        BITBOARD d_pushed_pawns =
+            move_to<up>(pushed_pawns & third_rank) & empty & target;
+        pushed_pawns &= target;
+
+        while (pushed_pawns) {
+            Square to = pop_ls1b(pushed_pawns);
+            *move_list++ = Move{to - up, to};
+        }
+
+        while (d_pushed_pawns) {
+            Square to = pop_ls1b(d_pushed_pawns);
+            *move_list++ = Move{to - up - up, to};
+        }
+    }
+
+    BITBOARD promoting = pawns & promotion_rank;
+    BITBOARD pawns_left = move_to<up_left>(pawns) & enemies;
+    BITBOARD pawns_right = move_to<up_right>(pawns) & enemies;
+    BITBOARD promote = move_to<up>(promoting) & empty & target;
+
+    while (pawns_left) {
+        Square to = pop_ls1b(pawns_left);
+        if (promoting & (to - up_left)) {
+            move_list = make_promotions<up_left>(move_list, to);
+        } else {
+            *move_list++ = Move{to - up_left, to};
+        }
+    }
+
+    while (pawns_right) {
+        Square to = pop_ls1b(pawns_right);
+        if (promoting & (to - up_right)) {
+            move_list = make_promotions<up_right>(move_list, to);
+        } else {
+            *move_list++ = Move{to - up_right, to};
+        }
+    }
+
+    while (promote) {
+        move_list = make_promotions<up>(move_list, pop_ls1b(promote));
+    }
+
+    return move_list;
+}
+
+template <Color Us, PieceType Pt>
+ScoredMoves* generate_legal_piece_moves(const Position& pos,
+                                        ScoredMoves* move_list,
+                                        BITBOARD target, BITBOARD pinned,
+                                        Square ksq) {
+    BITBOARD bb = pos.get_pieces_bb(Pt, Us);
+    BITBOARD all = pos.get_all_pieces_bb();
+
+    // A pinned knight can never stay on its pin line
+    if (Pt == KNIGHT) {
+        bb &= ~pinned;
+    }
+
+    while (bb) {
+        Square source = pop_ls1b(bb);
+        BITBOARD attacks = attacks_bb_by<Pt>(source, all) & target;
+
+        if (pinned & source) {
+            attacks &= line_bb(ksq, source);
+        }
+
+        while (attacks) {
+            *move_list++ = Move{source, pop_ls1b(attacks)};
+        }
+    }
+
+    return move_list;
+}
+
+template <Color Us, GenerationTypes Type>
+ScoredMoves* generate_all_legal(const Position& pos, ScoredMoves* move_list) {
+    constexpr Color them = ~Us;
+    constexpr Direction up = pawn_push_direction(Us);
+
+    const Square ksq = pos.square<KING>(Us);
+    const BITBOARD our = pos.get_our_pieces_bb();
+    const BITBOARD enemies = pos.get_opponent_pieces_bb();
+    const BITBOARD checkers = pos.get_attackers_to(ksq) & enemies;
+    const BITBOARD pinned = pos.get_king_blockers(Us) & our;
+
+    // The king steps to any square no enemy attacks once it has left ksq
+    BITBOARD k_bb = attacks_bb_by<KING>(ksq) & ~our;
+    if (Type == GT_LEGAL_CAPTURE) {
+        k_bb &= enemies;
+    }
+
+    BITBOARD occ = pos.get_all_pieces_bb() ^ ksq;
+    while (k_bb) {
+        Square to = pop_ls1b(k_bb);
+        if (!(pos.get_attackers_to(to, occ) & enemies)) {
+            *move_list++ = Move{ksq, to};
+        }
+    }
+
+    // In double check only the king moves
+    if (has_bit_after_pop(checkers)) {
+        return move_list;
+    }
+
+    // Where the other pieces may go: anywhere not ours, or in check onto
+    // the checker or a square between it and the king
+    BITBOARD target = checkers ? in_between_bb(ksq, get_ls1b(checkers)) : ~our;
+    BITBOARD piece_target =
+        (Type == GT_LEGAL_CAPTURE) ? (target & enemies) : target;
+
+    BITBOARD pawns = pos.get_pieces_bb(PAWN, Us);
+    move_list = generate_legal_pawn_moves<Us, Type>(pos, move_list,
+                                                    pawns & ~pinned, target);
+
+    // Pinned pawns one at a time, each held to its own pin line
+    BITBOARD pinned_pawns = pawns & pinned;
+    while (pinned_pawns) {
+        Square source = pop_ls1b(pinned_pawns);
+        move_list = generate_legal_pawn_moves<Us, Type>(
+            pos, move_list, square_to_BB(source),
+            target & line_bb(ksq, source));
+    }
+
+    // En passant can uncover a check along the rank the two pawns leave
+    Square ep_square = pos.ep_square();
+    if (ep_square != NONE) {
+        Square captured = ep_square - up;
+
+        if (!checkers || (checkers & captured) || (target & ep_square)) {
+            BITBOARD ep_pawns = pos.get_pieces_bb(PAWN, Us) &
+                                pawn_attacks_bb(them, ep_square);
+
+            while (ep_pawns) {
+                Move m{pop_ls1b(ep_pawns), ep_square, MT_EN_PASSANT};
+                if (pos.is_legal(m)) {
+                    *move_list++ = m;
+                }
+            }
+        }
+    }
+
+    move_list = generate_legal_piece_moves<Us, KNIGHT>(pos, move_list,
+                                                       piece_target, pinned, ksq);
+    move_list = generate_legal_piece_moves<Us, BISHOP>(pos, move_list,
+                                                       piece_target, pinned, ksq);
+    move_list = generate_legal_piece_moves<Us, ROOK>(pos, move_list,
+                                                     piece_target, pinned, ksq);
+    move_list = generate_legal_piece_moves<Us, QUEEN>(pos, move_list,
+                                                      piece_target, pinned, ksq);
+
+    if ((Type == GT_LEGAL) && !checkers && pos.can_castle(Us & ANY)) {
+        for (CastlingRights cr : {Us & KINGSIDE, Us & QUEENSIDE}) {
+            if (pos.can_castle(cr) && !pos.is_castling_interrupted(cr)) {
+                Move m{ksq, pos.castling_rook_square(cr), MT_CASTLING};
+                if (pos.is_legal(m)) {
+                    *move_list++ = m;
+                }
+            }
+        }
+    }
+
+    return move_list;
+}
+
 }  // namespace
 
 // returns a pointer at the end of the list
@@ -224,43 +409,22 @@ template ScoredMoves* generate_moves<GT_CAPTURE>(const Position&,
 template ScoredMoves* generate_moves<GT_QUIET>(const Position&, ScoredMoves*);
 template ScoredMoves* generate_moves<GT_EVADE>(const Position&, ScoredMoves*);
 
+// <GT_LEGAL>			generates all legal moves directly, see
+// generate_all_legal()
 template <>
 ScoredMoves* generate_moves<GT_LEGAL>(const Position& pos,
                                       ScoredMoves* move_list) {
-    Color us = pos.side_to_move();
-    Square ksq = pos.square<KING>(us);
-
-    BITBOARD pinned = pos.get_king_blockers(us) & pos.get_our_pieces_bb();
-
-    bool is_in_check = pos.get_attackers_to(ksq) & pos.get_opponent_pieces_bb();
-
-    ScoredMoves* legal_move_list = move_list;
-    ScoredMoves pseudo_legal_moves[MAX_MOVES];
-
-    // Checking if king is in check
-    // If it is, then we need to generate the evasions (since they are the only
-    // moves that are legal) else we will generate each move and check its
-    // legality
-    ScoredMoves* end_moves =
-        is_in_check ? generate_moves<GT_EVADE>(pos, pseudo_legal_moves)
-                    : generate_moves<GT_ALL>(pos, pseudo_legal_moves);
-
-    for (ScoredMoves* move = pseudo_legal_moves; move != end_moves; ++move) {
-        // Some checks that might be a precondition to an illegal move
-        bool is_pinned =
-            pinned & move->source_square();                // if pinned piece is moving
-        bool is_king_move = move->source_square() == ksq;  // if king is moving
-        bool is_ep = move->move_type() == MT_EN_PASSANT;   // if en passant is made
-
-        // Assuming other moves are legal
-        // if the preconditions pass we might be dealing with an illegal move
-        if ((is_pinned || is_king_move || is_ep) && !pos.is_legal(*move)) {
-            continue;
-        }
-
-        *legal_move_list++ = *move;
-    }
+    return pos.side_to_move() == WHITE
+               ? generate_all_legal<WHITE, GT_LEGAL>(pos, move_list)
+               : generate_all_legal<BLACK, GT_LEGAL>(pos, move_list);
+}
 
-    return legal_move_list;
+// <GT_LEGAL_CAPTURE>	legal captures and promotions, for quiescence
+template <>
+ScoredMoves* generate_moves<GT_LEGAL_CAPTURE>(const Position& pos,
+                                              ScoredMoves* move_list) {
+    return pos.side_to_move() == WHITE
+               ? generate_all_legal<WHITE, GT_LEGAL_CAPTURE>(pos, move_list)
+               : generate_all_legal<BLACK, GT_LEGAL_CAPTURE>(pos, move_list);
 }
 }  // namespace KhaosChess
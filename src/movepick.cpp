@@ -0,0 +1,306 @@
+#include "movepick.h"
+
+#include <utility>
+
+#include "bitboard.h"
+#include "score.h"
+
+namespace KhaosChess {
+namespace {
+// Evasion tiers: every evasion is scored at once, so the stages of the
+// main picker collapse into score bands
+constexpr std::int32_t QUIET_SCORE_MAX = HISTORY_MAX + CONTINUATION_HISTORY_MAX;
+constexpr std::int32_t SCORE_COUNTERMOVE = QUIET_SCORE_MAX + 1;
+constexpr std::int32_t SCORE_KILLER_SECONDARY = SCORE_COUNTERMOVE + 1;
+constexpr std::int32_t SCORE_KILLER_PRIMARY = SCORE_KILLER_SECONDARY + 1;
+constexpr std::int32_t SCORE_CAPTURE = SCORE_KILLER_PRIMARY + 1;
+constexpr std::int32_t SCORE_BAD_CAPTURE = -20'000;
+
+constexpr std::int32_t SCORE_QUIET_EVASION = -1'000'000;
+
+constexpr std::int32_t SCORE_PROMOTION_BONUS = 900;
+}  // namespace
+
+MovePicker::MovePicker(const Position& pos, Move tt_move, const Move* killers,
+                       Move countermove, const HistoryTable& history,
+                       const ContinuationTable* continuation)
+    : pos(pos),
+      tt_move(tt_move),
+      refutations{killers[0], killers[1], countermove},
+      history(&history),
+      continuation(continuation) {
+    // A killer repeated as the second killer or the countermove is tried once
+    if (refutations[1] == refutations[0]) {
+        refutations[1] = Move::invalid_move();
+    }
+    if ((refutations[2] == refutations[0]) ||
+        (refutations[2] == refutations[1])) {
+        refutations[2] = Move::invalid_move();
+    }
+
+    Color us = pos.side_to_move();
+    ksq = pos.square<KING>(us);
+    pinned = pos.get_king_blockers(us) & pos.get_our_pieces_bb();
+
+    bool in_check = pos.get_attackers_to(ksq) & pos.get_opponent_pieces_bb();
+    stage = in_check ? EVASION_TT : MAIN_TT;
+}
+
+MovePicker::MovePicker(const Position& pos, Move tt_move)
+    : pos(pos),
+      tt_move(tt_move),
+      refutations{Move::invalid_move(), Move::invalid_move(),
+                  Move::invalid_move()},
+      history(nullptr),
+      continuation(nullptr) {
+    Color us = pos.side_to_move();
+    ksq = pos.square<KING>(us);
+    pinned = pos.get_king_blockers(us) & pos.get_our_pieces_bb();
+
+    bool in_check = pos.get_attackers_to(ksq) & pos.get_opponent_pieces_bb();
+    stage = in_check ? EVASION_TT : QSEARCH_TT;
+}
+
+bool MovePicker::is_capture(Move m) const {
+    return ((m.move_type() != MT_CASTLING) && !pos.is_empty(m.target_square())) ||
+           (m.move_type() == MT_EN_PASSANT);
+}
+
+// Only pinned pieces, king moves and en passant can leave the king in
+// check, the same shortcut generate_moves<GT_LEGAL> takes
+bool MovePicker::is_legal(Move m) const {
+    bool is_pinned = pinned & m.source_square();
+    bool is_king_move = m.source_square() == ksq;
+    bool is_ep = m.move_type() == MT_EN_PASSANT;
+
+    return !(is_pinned || is_king_move || is_ep) || pos.is_legal(m);
+}
+
+// Killers and countermoves come from other positions: check they are still
+// quiet, pseudo-legal and legal here
+bool MovePicker::is_valid_quiet(Move m) const {
+    return (m != tt_move) && pos.is_pseudo_legal(m) && !is_capture(m) &&
+           (m.move_type() != MT_PROMOTION) && is_legal(m);
+}
+
+bool MovePicker::is_refutation(Move m) const {
+    return (m == refutations[0]) || (m == refutations[1]) ||
+           (m == refutations[2]);
+}
+
+// MVV-LVA, with promotions on top of whatever they capture
+std::int32_t MovePicker::capture_score(Move m) const {
+    PieceType victim = type_of_piece(pos.get_piece_on(m.target_square()));
+    PieceType aggressor = type_of_piece(pos.get_piece_on(m.source_square()));
+
+    std::int32_t score = MATERIAL_SCORES.piece_value[victim].mg -
+                         MATERIAL_SCORES.piece_value[aggressor].mg / 10;
+
+    if (m.move_type() == MT_PROMOTION) {
+        score += SCORE_PROMOTION_BONUS +
+                 MATERIAL_SCORES.piece_value[m.promoted()].mg;
+    }
+
+    return score;
+}
+
+// Butterfly history plus the continuation history of the previous move
+std::int32_t MovePicker::quiet_score(Move m) const {
+    Square source = m.source_square();
+    Square target = m.target_square();
+
+    std::int32_t score = (*history)[source][target];
+    if (continuation != nullptr) {
+        score += (*continuation)[pos.get_piece_on(source)][target];
+    }
+
+    return score;
+}
+
+void MovePicker::score_captures() {
+    for (ScoredMoves* it = cur; it != end_moves; ++it) {
+        it->score = capture_score(*it);
+    }
+}
+
+void MovePicker::score_quiets() {
+    for (ScoredMoves* it = cur; it != end_moves; ++it) {
+        it->score = quiet_score(*it);
+    }
+}
+
+// Evasions are few, so they are scored in one pass, SEE included
+void MovePicker::score_evasions() {
+    for (ScoredMoves* it = cur; it != end_moves; ++it) {
+        Move move = *it;
+
+        if (is_capture(move) || (move.move_type() == MT_PROMOTION)) {
+            it->score =
+                (pos.see_ge(move, 0) ? SCORE_CAPTURE : SCORE_BAD_CAPTURE) +
+                capture_score(move);
+        } else if (history == nullptr) {
+            // Quiescence has no quiet ordering: captures come first
+            it->score = SCORE_QUIET_EVASION;
+        } else if (move == refutations[0]) {
+            it->score = SCORE_KILLER_PRIMARY;
+        } else if (move == refutations[1]) {
+            it->score = SCORE_KILLER_SECONDARY;
+        } else if (move == refutations[2]) {
+            it->score = SCORE_COUNTERMOVE;
+        } else {
+            it->score = quiet_score(move);
+        }
+    }
+}
+
+// Selection step: swap the best remaining move to the front and take it.
+// Cheaper than a full sort when the node cuts off after a few moves.
+ScoredMoves* MovePicker::pick_best() {
+    ScoredMoves* best = cur;
+    for (ScoredMoves* it = cur + 1; it != end_moves; ++it) {
+        if (it->score > best->score) {
+            best = it;
+        }
+    }
+
+    std::swap(*best, *cur);
+    return cur++;
+}
+
+Move MovePicker::next_move() {
+    switch (stage) {
+        case MAIN_TT:
+        case EVASION_TT:
+            stage = (stage == MAIN_TT) ? CAPTURE_INIT : EVASION_INIT;
+            if (pos.is_pseudo_legal(tt_move) && is_legal(tt_move)) {
+                return tt_move;
+            }
+            tt_move = Move::invalid_move();
+            return next_move();
+
+        case QSEARCH_TT:
+            stage = QCAPTURE_INIT;
+            if (pos.is_pseudo_legal(tt_move) &&
+                (is_capture(tt_move) || (tt_move.move_type() == MT_PROMOTION)) &&
+                is_legal(tt_move)) {
+                return tt_move;
+            }
+            tt_move = Move::invalid_move();
+            return next_move();
+
+        case CAPTURE_INIT:
+            cur = end_bad_captures = moves;
+            end_moves = generate_moves<GT_CAPTURE>(pos, moves);
+            score_captures();
+            stage = GOOD_CAPTURE;
+            return next_move();
+
+        case GOOD_CAPTURE:
+            while (cur != end_moves) {
+                ScoredMoves* move = pick_best();
+
+                if ((*move == tt_move) || !is_legal(*move)) {
+                    continue;
+                }
+
+                // Losing captures wait until after the quiets
+                if (!pos.see_ge(*move, 0)) {
+                    *end_bad_captures++ = *move;
+                    continue;
+                }
+
+                return *move;
+            }
+            stage = KILLER_PRIMARY;
+            [[fallthrough]];
+
+        case KILLER_PRIMARY:
+        case KILLER_SECONDARY:
+        case COUNTERMOVE:
+            while (stage <= COUNTERMOVE) {
+                Move& move = refutations[stage - KILLER_PRIMARY];
+                stage = Stage(stage + 1);
+
+                if (is_valid_quiet(move)) {
+                    return move;
+                }
+
+                // Not tried here, so the quiet stage must not skip it
+                move = Move::invalid_move();
+            }
+            [[fallthrough]];
+
+        case QUIET_INIT:
+            cur = end_bad_captures;
+            end_moves = generate_moves<GT_QUIET>(pos, cur);
+            score_quiets();
+            stage = QUIET;
+            [[fallthrough]];
+
+        case QUIET:
+            while (cur != end_moves) {
+                ScoredMoves* move = pick_best();
+
+                if ((*move == tt_move) || is_refutation(*move) ||
+                    !is_legal(*move)) {
+                    continue;
+                }
+
+                return *move;
+            }
+            cur = moves;
+            end_moves = end_bad_captures;
+            stage = BAD_CAPTURE;
+            [[fallthrough]];
+
+        case BAD_CAPTURE:
+            if (cur != end_moves) {
+                return *cur++;
+            }
+            break;
+
+        case EVASION_INIT:
+            cur = moves;
+            end_moves = generate_moves<GT_EVADE>(pos, moves);
+            score_evasions();
+            stage = EVASION;
+            [[fallthrough]];
+
+        case EVASION:
+            while (cur != end_moves) {
+                ScoredMoves* move = pick_best();
+
+                if ((*move == tt_move) || !is_legal(*move)) {
+                    continue;
+                }
+
+                return *move;
+            }
+            break;
+
+        // Already legal: no check needed as they come out
+        case QCAPTURE_INIT:
+            cur = moves;
+            end_moves = generate_moves<GT_LEGAL_CAPTURE>(pos, moves);
+            score_captures();
+            stage = QCAPTURE;
+            [[fallthrough]];
+
+        case QCAPTURE:
+            while (cur != end_moves) {
+                ScoredMoves* move = pick_best();
+
+                if (*move != tt_move) {
+                    return *move;
+                }
+            }
+            break;
+
+        case DONE:
+            break;
+    }
+
+    stage = DONE;
+    return Move::invalid_move();
+}
+}  // namespace KhaosChess
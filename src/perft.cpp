@@ -0,0 +1,185 @@
+#include "perft.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "thread.h"
+
+namespace KhaosChess {
+namespace {
+// Subtree counts keyed by Zobrist key and remaining depth. Always-replace,
+// one entry per slot. The key word is stored XORed with the data word, the
+// TT's lockless check: an entry torn by two threads writing at once reads
+// as a miss instead of a wrong count.
+class PerftHash {
+   public:
+    explicit PerftHash(std::size_t mb) {
+        std::size_t entries = mb * 1024 * 1024 / sizeof(Entry);
+        std::size_t size = 1;
+        while (size * 2 <= entries) {
+            size *= 2;
+        }
+        table = std::vector<Entry>(size);
+        mask = size - 1;
+    }
+
+    bool probe(BITBOARD key, std::int32_t depth, std::uint64_t& nodes) const {
+        const Entry& e = table[key & mask];
+        std::uint64_t data = e.data.load(std::memory_order_relaxed);
+        std::uint64_t check = e.check.load(std::memory_order_relaxed);
+
+        if (((check ^ data) != key) ||
+            static_cast<std::int32_t>(data & 0xFF) != depth) {
+            return false;
+        }
+        nodes = data >> 8;
+        return true;
+    }
+
+    // Counts need at most 56 bits: startpos depth 10 is about 2^46
+    void store(BITBOARD key, std::int32_t depth, std::uint64_t nodes) {
+        Entry& e = table[key & mask];
+        std::uint64_t data = (nodes << 8) | static_cast<std::uint64_t>(depth);
+        e.check.store(key ^ data, std::memory_order_relaxed);
+        e.data.store(data, std::memory_order_relaxed);
+    }
+
+   private:
+    struct Entry {
+        std::atomic<std::uint64_t> check{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+
+    std::vector<Entry> table;
+    std::size_t mask = 0;
+};
+
+std::uint64_t perft_search(Position& pos, std::int32_t depth, bool bulk,
+                           PerftHash* hash) {
+    if (depth == 0) {
+        return 1;
+    }
+
+    // Below depth 2 a probe costs about what generating the moves does
+    std::uint64_t nodes = 0;
+    if (hash && depth >= 2 && hash->probe(pos.key(), depth, nodes)) {
+        return nodes;
+    }
+
+    MoveList<GT_LEGAL> moves(pos);
+    if (bulk && depth == 1) {
+        return moves.size();
+    }
+
+    for (const auto& m : moves) {
+        MoveInfo move_info;
+        pos.do_move(m, move_info);
+        nodes += perft_search(pos, depth - 1, bulk, hash);
+        pos.undo_move(m);
+    }
+
+    if (hash && depth >= 2) {
+        hash->store(pos.key(), depth, nodes);
+    }
+    return nodes;
+}
+
+// Count below each root move. With several threads the root moves are
+// handed out one at a time from a shared index, so a worker that drew a
+// small subtree takes the next move instead of idling. Every worker plays
+// on its own board set up from the root FEN; the hash is shared.
+std::vector<std::uint64_t> perft_root(Position& pos, std::int32_t depth,
+                                      const PerftOptions& options,
+                                      std::vector<Move>& root_moves) {
+    for (const auto& m : MoveList<GT_LEGAL>(pos)) {
+        root_moves.push_back(m);
+    }
+    std::vector<std::uint64_t> counts(root_moves.size(), 0);
+
+    std::unique_ptr<PerftHash> hash;
+    if (options.hash_mb > 0) {
+        hash = std::make_unique<PerftHash>(options.hash_mb);
+    }
+
+    if (options.threads <= 1 || depth <= 2) {
+        for (std::size_t i = 0; i < root_moves.size(); ++i) {
+            MoveInfo move_info;
+            pos.do_move(root_moves[i], move_info);
+            counts[i] =
+                perft_search(pos, depth - 1, options.bulk, hash.get());
+            pos.undo_move(root_moves[i]);
+        }
+        return counts;
+    }
+
+    const std::string fen = pos.get_fen();
+    std::atomic<std::size_t> next{0};
+
+    Threads.set_count(options.threads);
+    Threads.run_on_workers([&](std::size_t, std::size_t) {
+        Position board;
+        MoveInfo root_info{};
+        board.set(fen, &root_info);
+
+        for (std::size_t i = next++; i < root_moves.size(); i = next++) {
+            MoveInfo move_info;
+            board.do_move(root_moves[i], move_info);
+            counts[i] =
+                perft_search(board, depth - 1, options.bulk, hash.get());
+            board.undo_move(root_moves[i]);
+        }
+    });
+
+    return counts;
+}
+}  // namespace
+
+std::uint64_t perft(Position& pos, std::int32_t depth,
+                    const PerftOptions& options) {
+    if (depth <= 0) {
+        return 1;
+    }
+
+    std::vector<Move> root_moves;
+    std::vector<std::uint64_t> counts =
+        perft_root(pos, depth, options, root_moves);
+
+    std::uint64_t nodes = 0;
+    for (std::uint64_t count : counts) {
+        nodes += count;
+    }
+    return nodes;
+}
+
+std::uint64_t perft_debug(Position& pos, std::int32_t depth,
+                          const PerftOptions& options) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    std::vector<Move> root_moves;
+    std::vector<std::uint64_t> counts;
+    if (depth > 0) {
+        counts = perft_root(pos, depth, options, root_moves);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+
+    std::uint64_t nodes = 0;
+    for (std::size_t i = 0; i < root_moves.size(); ++i) {
+        std::cout << root_moves[i].uci_move() << ": " << counts[i] << "\n";
+        nodes += counts[i];
+    }
+
+    std::cout << "\nNodes: " << nodes;
+    std::cout << "\nDepth: " << depth;
+    std::cout << "\nTime: " << elapsed.count() << "ms";
+    std::cout << "\nNPS: "
+              << nodes * 1000 / std::max<std::int64_t>(elapsed.count(), 1)
+              << std::endl;
+
+    return nodes;
+}
+}  // namespace KhaosChess
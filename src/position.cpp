@@ -2,6 +2,7 @@
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -115,7 +116,7 @@ Position& Position::set(const std::string& fen, MoveInfo* mi) {
     File file = FILE_A;
 
     // reset boards and state variables
-    memset(this, 0, sizeof(Position));
+    memset(static_cast<void*>(this), 0, sizeof(Position));
     memset(mi, 0, sizeof(MoveInfo));
     move_info = mi;
 
@@ -186,7 +187,7 @@ Position& Position::set(const std::string& fen, MoveInfo* mi) {
     if (idx < fen.length() && fen[idx] != '-') {
         // init en_passant suqare
         move_info->en_passant =
-            make_square(File(fen[idx] - 'a'), Rank(8 - (fen[idx] - '0')));
+            make_square(File(fen[idx] - 'a'), Rank(8 - (fen[idx + 1] - '0')));
 
         idx += 2;  // skip the en passant square and space
     } else {
@@ -211,6 +212,7 @@ Position& Position::set(const std::string& fen, MoveInfo* mi) {
     // Calculate threats
     calculate_threats();
     move_info->key = compute_key();
+    move_info->pawn_key = compute_pawn_key();
 
     return *this;
 }
@@ -317,6 +319,30 @@ BITBOARD Position::compute_key() const {
     return k;
 }
 
+// A board without pawns keys to 0, like an empty pawn table entry, whose
+// zero scores and bitboards are indeed what such a board evaluates to
+BITBOARD Position::compute_pawn_key() const {
+    BITBOARD k = 0;
+
+    for (Color c : {WHITE, BLACK}) {
+        BITBOARD pawns = get_pieces_bb(PAWN, c);
+        while (pawns) {
+            k ^= Zobrist::psq[get_piece(c, PAWN)][pop_ls1b(pawns)];
+        }
+    }
+
+    return k;
+}
+
+// The PCV from the piece counts, to verify the incremental material key
+PCV Position::compute_pcv() const {
+    return encode_pcv(count<PAWN>(WHITE), count<KNIGHT>(WHITE),
+                      count<BISHOP>(WHITE), count<ROOK>(WHITE),
+                      count<QUEEN>(WHITE), count<PAWN>(BLACK),
+                      count<KNIGHT>(BLACK), count<BISHOP>(BLACK),
+                      count<ROOK>(BLACK), count<QUEEN>(BLACK));
+}
+
 // Shows a bitboard of the possible pieces that can give check to the opposite
 // king in a given position
 BITBOARD Position::get_checked_squares(PieceType pt) const {
@@ -425,6 +451,65 @@ bool Position::gives_check(Move m) const {
     }
 }
 
+// Mirrors the key updates of do_move without touching the board, so the
+// result must match move_info->key after do_move(m) exactly, en passant
+// and castling rights included. Move is assumed to be legal
+BITBOARD Position::key_after(Move m) const {
+    assert(m.is_move_ok());
+
+    Color us = side;
+    Color them = ~us;
+
+    Square source = m.source_square();
+    Square target = m.target_square();
+
+    MoveType m_type = m.move_type();
+
+    Piece on_source = get_piece_on(source);
+
+    BITBOARD k = move_info->key ^ Zobrist::side;
+
+    if (move_info->en_passant != NONE) {
+        k ^= Zobrist::en_passant[file_of(move_info->en_passant)];
+    }
+
+    CastlingRights cr = move_info->castling_rights & CASTLING_RIGHTS_TABLE[source];
+    cr = cr & CASTLING_RIGHTS_TABLE[target];
+    k ^= Zobrist::castling[move_info->castling_rights] ^ Zobrist::castling[cr];
+
+    // Castling is encoded as king captures rook
+    if (m_type == MT_CASTLING) {
+        Piece rook = get_piece(us, ROOK);
+        bool king_side = target > source;
+        Square k_target = sq_relative_to_side(king_side ? G1 : C1, us);
+        Square r_target = sq_relative_to_side(king_side ? F1 : D1, us);
+
+        return k ^ Zobrist::psq[on_source][source] ^
+               Zobrist::psq[on_source][k_target] ^ Zobrist::psq[rook][target] ^
+               Zobrist::psq[rook][r_target];
+    }
+
+    if (m_type == MT_EN_PASSANT) {
+        k ^= Zobrist::psq[get_piece(them, PAWN)][target - pawn_push_direction(us)];
+    } else if (Piece captured = get_piece_on(target)) {
+        k ^= Zobrist::psq[captured][target];
+    }
+
+    Piece arriving =
+        m_type == MT_PROMOTION ? get_piece(us, m.promoted()) : on_source;
+    k ^= Zobrist::psq[on_source][source] ^ Zobrist::psq[arriving][target];
+
+    // A double push only sets the en passant square if a pawn can take
+    if (type_of_piece(on_source) == PAWN &&
+        (std::int32_t(target) ^ std::int32_t(source)) == 16 &&
+        (pawn_attacks_bb(us, target - pawn_push_direction(us)) &
+         get_pieces_bb(PAWN, them))) {
+        k ^= Zobrist::en_passant[file_of(target)];
+    }
+
+    return k;
+}
+
 // Makes a move and saves the information in the Info
 // Move is assumed to be legal
 void Position::do_move(const Move& m, MoveInfo& new_info) {
@@ -475,6 +560,9 @@ void Position::do_move(const Move& m, MoveInfo& new_info) {
            get_piece_color(captured) == (m_type != MT_CASTLING ? them : us));
     assert(type_of_piece(captured) != KING);  // make sure king is not captured
 
+    // Squares the move empties or fills, to see whose king lines it touches
+    BITBOARD changed = square_to_BB(source);
+
     // Castling
     if (m_type == MT_CASTLING) {
         assert(on_source == get_piece(us, KING));  // source piece is our king
@@ -483,6 +571,7 @@ void Position::do_move(const Move& m, MoveInfo& new_info) {
 
         Square r_source, r_target;
         do_castle<true>(us, source, target, r_source, r_target);
+        changed |= square_to_BB(r_source) | r_target;
 
         k ^= Zobrist::psq[on_source][source] ^ Zobrist::psq[on_source][target];
         k ^= Zobrist::psq[captured][r_source] ^ Zobrist::psq[captured][r_target];
@@ -506,6 +595,11 @@ void Position::do_move(const Move& m, MoveInfo& new_info) {
 
         remove_piece(capture_sq);
         k ^= Zobrist::psq[captured][capture_sq];
+        changed |= capture_sq;
+
+        if (type_of_piece(captured) == PAWN) {
+            move_info->pawn_key ^= Zobrist::psq[captured][capture_sq];
+        }
 
         move_info->fifty_move = 0;
     }
@@ -531,6 +625,12 @@ void Position::do_move(const Move& m, MoveInfo& new_info) {
     }
 
     if (type_of_piece(on_source) == PAWN) {
+        // A promoting pawn leaves the pawns for good
+        move_info->pawn_key ^= Zobrist::psq[on_source][source];
+        if (m_type != MT_PROMOTION) {
+            move_info->pawn_key ^= Zobrist::psq[on_source][target];
+        }
+
         // Set an en passant square if the moved pawn can be captured
         if ((std::int32_t(target) ^ std::int32_t(source)) == 16  // double push
             && (pawn_attacks_bb(us, target - pawn_push_direction(us)) &
@@ -562,8 +662,21 @@ void Position::do_move(const Move& m, MoveInfo& new_info) {
     move_info->key = k;
 
     assert(move_info->key == compute_key());
+    assert(move_info->pawn_key == compute_pawn_key());
+    assert(get_pcv() == compute_pcv());
+
+    // The king lines came over from the previous move. A king's only change
+    // when it moves or when the move empties or fills a square on one of
+    // its lines, which most moves do for one king at most
+    changed |= target;
+    for (Color c : {us, them}) {
+        bool king_moved = (c == us) && (type_of_piece(on_source) == KING);
+        if (king_moved || (changed & pseudo_attacks[QUEEN][square<KING>(c)])) {
+            update_king_lines(c);
+        }
+    }
 
-    calculate_threats();
+    assert(king_lines_ok());
 }
 
 void Position::undo_move(const Move& m) {
@@ -619,11 +732,9 @@ void Position::undo_move(const Move& m) {
         }
     }
 
-    // return to the previous state
+    // return to the previous state, king lines included
     move_info = move_info->prev;
     fullmove_number--;
-
-    calculate_threats();
 }
 
 // Passes the turn without moving: only side to move and en passant
@@ -654,7 +765,7 @@ void Position::do_null_move(MoveInfo& new_info) {
 
     assert(move_info->key == compute_key());
 
-    calculate_threats();
+    // No piece moved, so the copied king lines still hold
 }
 
 void Position::undo_null_move() {
@@ -662,8 +773,6 @@ void Position::undo_null_move() {
 
     move_info = move_info->prev;
     fullmove_number--;
-
-    calculate_threats();
 }
 
 bool Position::is_legal(Move m) const {
@@ -747,6 +856,113 @@ bool Position::is_legal(Move m) const {
            are_squares_aligned(source, target, ksq);
 }
 
+bool Position::is_pseudo_legal(Move m) const {
+    if (!m.is_move_ok()) {
+        return false;
+    }
+
+    Color us = side;
+    Square source = m.source_square();
+    Square target = m.target_square();
+    Piece pc = get_piece_on(source);
+
+    if ((pc == NO_PIECE) || (get_piece_color(pc) != us)) {
+        return false;
+    }
+
+    Square ksq = square<KING>(us);
+    BITBOARD checkers = get_attackers_to(ksq) & get_opponent_pieces_bb();
+    MoveType mt = m.move_type();
+    PieceType pt = type_of_piece(pc);
+
+    // Only a promotion carries promotion bits
+    if ((mt != MT_PROMOTION) && (m.move_value() >> 14)) {
+        return false;
+    }
+
+    // Castling is king takes own rook: the right must still be there, the
+    // path empty and no square the king stands on or crosses attacked
+    if (mt == MT_CASTLING) {
+        CastlingRights cr = us & (target > source ? KINGSIDE : QUEENSIDE);
+
+        if ((pt != KING) || checkers || !can_castle(cr) ||
+            (castling_rook_square(cr) != target) ||
+            is_castling_interrupted(cr)) {
+            return false;
+        }
+
+        Square k_target = sq_relative_to_side(target > source ? G1 : C1, us);
+        Direction step = target > source ? LEFT : RIGHT;
+
+        for (Square s = k_target; s != source; s += step) {
+            if (is_square_attacked(s, ~us)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // En passant takes onto the en passant square, which is only set when
+    // a pawn can; in check the pawn it takes has to be the checker, or the
+    // square has to block
+    if (mt == MT_EN_PASSANT) {
+        if ((pt != PAWN) || (target != ep_square()) ||
+            !(pawn_attacks_bb(us, source) & target)) {
+            return false;
+        }
+
+        if (!checkers) {
+            return true;
+        }
+
+        return !has_bit_after_pop(checkers) &&
+               ((checkers & (target - pawn_push_direction(us))) ||
+                (in_between_bb(ksq, get_ls1b(checkers)) & target));
+    }
+
+    // A pawn reaching the last rank promotes, and nothing else does
+    if ((mt == MT_PROMOTION) !=
+        ((pt == PAWN) &&
+         (rank_of(target) == rank_relative_to_side(us, RANK_8)))) {
+        return false;
+    }
+
+    // Never lands on our own piece
+    if (get_our_pieces_bb() & target) {
+        return false;
+    }
+
+    if (pt == PAWN) {
+        Direction up = pawn_push_direction(us);
+        bool is_capture = pawn_attacks_bb(us, source) & get_opponent_pieces_bb() &
+                          target;
+        bool is_push = (source + up == target) && is_empty(target);
+        bool is_double_push =
+            (rank_of(source) == rank_relative_to_side(us, RANK_2)) &&
+            (source + up + up == target) && is_empty(source + up) &&
+            is_empty(target);
+
+        if (!is_capture && !is_push && !is_double_push) {
+            return false;
+        }
+    } else if (!(attacks_bb_by(pt, source, get_all_pieces_bb()) & target)) {
+        return false;
+    }
+
+    // In check, anything but the king has to take or block the only checker;
+    // is_legal() covers where the king may go
+    if (checkers && (pt != KING)) {
+        if (has_bit_after_pop(checkers)) {
+            return false;
+        }
+
+        return in_between_bb(ksq, get_ls1b(checkers)) & target;
+    }
+
+    return true;
+}
+
 // Helper for do/undo castling move
 template <bool Do>
 void Position::do_castle(Color us, Square source, Square& target,
@@ -808,27 +1024,39 @@ void Position::set_castling_rights(Color c, Square r_source) {
 }
 
 void Position::calculate_threats() {
-    update_blocks_and_pins(WHITE);
-    update_blocks_and_pins(BLACK);
-
-    Square ksq = square<KING>(~side);
-
-    BITBOARD all = get_all_pieces_bb();
+    update_king_lines(WHITE);
+    update_king_lines(BLACK);
+}
 
-    threats[PAWN] = pawn_attacks_bb(~side, ksq);
-    threats[KNIGHT] = attacks_bb_by<KNIGHT>(ksq);
-    threats[BISHOP] = attacks_bb_by<BISHOP>(ksq, all);
-    threats[ROOK] = attacks_bb_by<ROOK>(ksq, all);
-    threats[QUEEN] = threats[BISHOP] | threats[ROOK];
-    threats[KING] = 0;  // Can't have threats by king
+void Position::update_king_lines(Color c) {
+    compute_king_lines(c, *move_info);
 }
 
-void Position::update_blocks_and_pins(Color c) {
-    blocking_pieces[c] = 0ULL;
-    pinning_pieces[~c] = 0ULL;
+// Fills king c's blockers and check squares, and the pinners of the other
+// side, into info from the current board
+void Position::compute_king_lines(Color c, MoveInfo& info) const {
+    info.king_blockers[c] = 0ULL;
+    info.pinners[~c] = 0ULL;
+    std::fill(std::begin(info.check_squares[c]),
+              std::end(info.check_squares[c]), 0ULL);
 
     Square ksq = square<KING>(c);
 
+    // Kingless boards (the empty boot position) have no lines to keep
+    if (ksq == NONE) {
+        return;
+    }
+
+    BITBOARD all = get_all_pieces_bb();
+    BITBOARD* checks = info.check_squares[c];
+
+    checks[PAWN] = pawn_attacks_bb(c, ksq);
+    checks[KNIGHT] = attacks_bb_by<KNIGHT>(ksq);
+    checks[BISHOP] = attacks_bb_by<BISHOP>(ksq, all);
+    checks[ROOK] = attacks_bb_by<ROOK>(ksq, all);
+    checks[QUEEN] = checks[BISHOP] | checks[ROOK];
+    checks[KING] = 0;  // Can't have threats by king
+
     BITBOARD color_pieces = get_pieces_bb(c);
 
     // snipers are calculated such that there are no pieces on the board
@@ -839,7 +1067,7 @@ void Position::update_blocks_and_pins(Color c) {
         get_pieces_bb(~c);
 
     // All pieces without the snipers
-    BITBOARD occ = get_all_pieces_bb() ^ snipers;
+    BITBOARD occ = all ^ snipers;
 
     // looping through all the snipers
     while (snipers) {
@@ -851,17 +1079,34 @@ void Position::update_blocks_and_pins(Color c) {
         // and is still left space after removing a bit
         // then there is greater than or equal to one blocker between them
         if (btw && !has_bit_after_pop(btw)) {
-            blocking_pieces[c] |= btw;
+            info.king_blockers[c] |= btw;
 
             // If the blocking piece is of the opposite colour
             // the blocker is pinned by the pinner (the sniper)
             if (btw & color_pieces) {
-                pinning_pieces[~c] |= sniper_sq;
+                info.pinners[~c] |= sniper_sq;
             }
         }
     }
 }
 
+// Debug check for do_move: the king lines it kept or redid must match a
+// recompute of both from scratch
+bool Position::king_lines_ok() const {
+    MoveInfo full = *move_info;
+    compute_king_lines(WHITE, full);
+    compute_king_lines(BLACK, full);
+
+    return std::equal(std::begin(full.king_blockers),
+                      std::end(full.king_blockers),
+                      std::begin(move_info->king_blockers)) &&
+           std::equal(std::begin(full.pinners), std::end(full.pinners),
+                      std::begin(move_info->pinners)) &&
+           std::equal(&full.check_squares[0][0],
+                      &full.check_squares[0][0] + BOTH * PIECE_TYPE_NB,
+                      &move_info->check_squares[0][0]);
+}
+
 // Fifty-move rule and (single) repetition detection. Scoring the first
 // repetition as a draw is intentional: if repeating once is best play,
 // repeating twice more changes nothing
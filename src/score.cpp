@@ -16,45 +16,148 @@ Score psqt_bonus(PieceType pt, Square s, Color us) {
     return PSQT[pt][sq_relative_to_side(s, us)];
 }
 
-constexpr BITBOARD opponent_ranks_for(Color c) {
-    return c == WHITE ? Rank8_Bits | Rank7_Bits | Rank6_Bits | Rank5_Bits
-                      : Rank1_Bits | Rank2_Bits | Rank3_Bits | Rank4_Bits;
+// Whether a scorer adds the terms the full eval keeps apart: material and
+// PSQT, which it takes from the Position's running sum, and the material
+// imbalance, which it takes from the material table. The full eval passes
+// WithPsq = false
+template <ScoreComponent Component, bool WithPsq>
+constexpr bool scores_material =
+    WithPsq && (Component == SC_MATERIAL || Component == SC_ALL);
+
+template <ScoreComponent Component, bool WithPsq>
+constexpr bool scores_psqt = WithPsq && PSQT_ENABLED && Component == SC_ALL;
+
+template <ScoreComponent Component, bool WithPsq>
+constexpr bool scores_imbalance =
+    Component == SC_PIECE_COORDINATION || (WithPsq && Component == SC_ALL);
+
+// Material + PSQT of one piece on s, from White's point of view
+Score piece_square(Piece p, Square s) {
+    const PieceType pt = type_of_piece(p);
+    const Color c = get_piece_color(p);
+    Score v = MATERIAL_SCORES.piece_value[pt];
+
+    if (PSQT_ENABLED) {
+        v += psqt_bonus(pt, s, c);
+    }
+
+    return c == WHITE ? v : -v;
+}
+
+// What Position::psq_score() sums incrementally, summed from the board and
+// the live weights
+Score psq_from_scratch(const Position& pos) {
+    Score score = 0;
+
+    for (Square s = A8; s <= H1; ++s) {
+        if (pos.get_piece_on(s) != NO_PIECE) {
+            score += piece_square(pos.get_piece_on(s), s);
+        }
+    }
+
+    return score;
 }
 
-BITBOARD get_real_possible_moves(const Color c, const Position& pos, Square s,
-                                 BITBOARD moves) {
-    const Square ksq = pos.square<KING>(c);
+Value phase_from_scratch(const Position& pos) {
+    Value w = 0;
 
-    // Get all opponent pieces, except pawns
-    BITBOARD opp_pieces = pos.get_pieces_bb(~c) ^ pos.get_pieces_bb(PAWN, ~c);
+    for (PieceType pt = KNIGHT; pt <= QUEEN; ++pt) {
+        w += (pos.count(WHITE, pt) + pos.count(BLACK, pt)) * PIECE_WEIGHTS[pt];
+    }
 
-    if (pos.get_king_blockers(c) & s) {
-        moves &= in_between_bb(s, ksq);
+    return std::min(w, MAX_PIECE_WEIGHTS);
+}
+
+// The terms that depend on the material alone: the bishop pair
+Score score_imbalance(const Position& pos) {
+    Score score = 0;
+
+    if (pos.count<BISHOP>(WHITE) >= 2) {
+        score += PIECE_SCORES.bishop_pair;
     }
+    if (pos.count<BISHOP>(BLACK) >= 2) {
+        score -= PIECE_SCORES.bishop_pair;
+    }
+
+    return score;
+}
 
-    // cannot move into square with our piece
-    moves &= ~pos.get_pieces_bb(c);
+constexpr BITBOARD opponent_ranks_for(Color c) {
+    return c == WHITE ? Rank8_Bits | Rank7_Bits | Rank6_Bits | Rank5_Bits
+                      : Rank1_Bits | Rank2_Bits | Rank3_Bits | Rank4_Bits;
+}
 
-    // Get the other sides's pawn attacks into one bitboard
-    BITBOARD opp_pawns = pos.get_pieces_bb(PAWN, ~c);
-    BITBOARD opp_pawn_attacks = 0ULL;
+// The attacks the scorers share, computed once per eval instead of once
+// per piece that reads them
+struct EvalInfo {
+    EvalInfo(const Position& pos, const PawnEntry* pawns = nullptr);
+
+    // attacked_by[c][pt]: the squares c's pieces of type pt attack;
+    // attacked_by[c][ALL_PIECES]: all the squares c attacks
+    BITBOARD attacked_by[BOTH][PIECE_TYPE_NB] = {};
+
+    // Where c's pieces count as mobile: not onto their own pieces, and
+    // not onto enemy pieces the enemy pawns defend
+    BITBOARD mobility_area[BOTH];
+
+    // c's king and the squares around it
+    BITBOARD king_zone[BOTH];
+
+   private:
+    template <PieceType pt>
+    void add_attacks(const Position& pos, Color c);
+};
+
+template <PieceType pt>
+void EvalInfo::add_attacks(const Position& pos, Color c) {
+    BITBOARD pieces = pos.get_pieces_bb(pt, c);
+    while (pieces) {
+        attacked_by[c][pt] |=
+            attacks_bb_by<pt>(pop_ls1b(pieces), pos.get_all_pieces_bb());
+    }
+    attacked_by[c][ALL_PIECES] |= attacked_by[c][pt];
+}
+
+EvalInfo::EvalInfo(const Position& pos, const PawnEntry* pawns) {
+    for (Color c : {WHITE, BLACK}) {
+        attacked_by[c][PAWN] =
+            pawns != nullptr ? pawns->attacks[c] : pos.get_attacks_by<PAWN>(c);
+        attacked_by[c][ALL_PIECES] = attacked_by[c][PAWN];
+
+        add_attacks<KNIGHT>(pos, c);
+        add_attacks<BISHOP>(pos, c);
+        add_attacks<ROOK>(pos, c);
+        add_attacks<QUEEN>(pos, c);
+
+        const Square ksq = pos.square<KING>(c);
+        attacked_by[c][KING] = attacks_bb_by<KING>(ksq);
+        attacked_by[c][ALL_PIECES] |= attacked_by[c][KING];
+        king_zone[c] = attacked_by[c][KING] | ksq;
+    }
 
-    while (opp_pawns) {
-        opp_pawn_attacks |= pawn_attacks_bb(~c, pop_ls1b(opp_pawns));
+    for (Color c : {WHITE, BLACK}) {
+        const BITBOARD opp_pieces =
+            pos.get_pieces_bb(~c) ^ pos.get_pieces_bb(PAWN, ~c);
+        mobility_area[c] =
+            ~(pos.get_pieces_bb(c) | (attacked_by[~c][PAWN] & opp_pieces));
     }
+}
 
-    // Don't count squares attacked by opponents pawns with nothing valuable
-    // there
-    moves &= ~(opp_pawn_attacks & opp_pieces);
+BITBOARD get_real_possible_moves(const Color c, const Position& pos,
+                                 const EvalInfo& ei, Square s, BITBOARD moves) {
+    if (pos.get_king_blockers(c) & s) {
+        moves &= in_between_bb(s, pos.square<KING>(c));
+    }
 
-    return moves;
+    return moves & ei.mobility_area[c];
 }
 
 // Score the pawns by given component and color
 // Returns the score for the given component and color
 // Does not score pawn shield, this is left for the king safety scoring
-template <ScoreComponent Component, Color Us>
-Score score_pawns(const Position& pos) {
+// The passed pawns found go to `passed` when given
+template <ScoreComponent Component, Color Us, bool WithPsq = true>
+Score score_pawns(const Position& pos, BITBOARD* passed = nullptr) {
     constexpr Color Them = ~Us;
     constexpr Direction Up = pawn_push_direction(Us);
     constexpr Direction Down = pawn_push_direction(Them);
@@ -65,7 +168,7 @@ Score score_pawns(const Position& pos) {
     BITBOARD our_pawns = pos.get_pieces_bb(PAWN, Us);
     BITBOARD opp_pawns = pos.get_pieces_bb(PAWN, Them);
 
-    if (Component == SC_MATERIAL || Component == SC_ALL) {
+    if (scores_material<Component, WithPsq>) {
         score += MATERIAL_SCORES.piece_value[PAWN] * Value(pos.count<PAWN>(Us));
     }
 
@@ -83,7 +186,7 @@ Score score_pawns(const Position& pos) {
     while (pawns) {
         Square s = pop_ls1b(pawns);
 
-        if (PSQT_ENABLED && Component == SC_ALL) {
+        if (scores_psqt<Component, WithPsq>) {
             score += psqt_bonus(PAWN, s, Us);
         }
 
@@ -141,6 +244,9 @@ Score score_pawns(const Position& pos) {
             if (is_passed) {
                 score += PAWN_STRUCTURE_SCORES.passed *
                          PAWN_STRUCTURE_SCORES.passed_rank_weight[rel_r];
+                if (passed) {
+                    *passed |= s;
+                }
             }
         }
     }
@@ -148,8 +254,8 @@ Score score_pawns(const Position& pos) {
     return score;
 }
 
-template <ScoreComponent Component, Color Us>
-Score score_knights(const Position& pos) {
+template <ScoreComponent Component, Color Us, bool WithPsq = true>
+Score score_knights(const Position& pos, const EvalInfo& ei) {
     constexpr Color Them = ~Us;
     constexpr BITBOARD center_bits =
         FileC_Bits | FileD_Bits | FileE_Bits | FileF_Bits;
@@ -159,7 +265,7 @@ Score score_knights(const Position& pos) {
 
     BITBOARD knights = pos.get_pieces_bb(KNIGHT, Us);
 
-    if (Component == SC_MATERIAL || Component == SC_ALL) {
+    if (scores_material<Component, WithPsq>) {
         score +=
             MATERIAL_SCORES.piece_value[KNIGHT] * Value(pos.count<KNIGHT>(Us));
     }
@@ -172,13 +278,13 @@ Score score_knights(const Position& pos) {
         Square s = pop_ls1b(knights);
         BITBOARD attacking = attacks_bb_by<KNIGHT>(s);
 
-        if (PSQT_ENABLED && Component == SC_ALL) {
+        if (scores_psqt<Component, WithPsq>) {
             score += psqt_bonus(KNIGHT, s, Us);
         }
 
         // Piece coordination
         if (Component == SC_PIECE_COORDINATION || Component == SC_ALL) {
-            if (pos.get_attacks_by<PAWN>(Us) & square_to_BB(s)) {
+            if (ei.attacked_by[Us][PAWN] & square_to_BB(s)) {
                 score += PIECE_SCORES.safe_knight;
             }
         }
@@ -205,7 +311,7 @@ Score score_knights(const Position& pos) {
                      Value(count_bits(attacking & opp_ranks));
 
             // Mobility bonus
-            BITBOARD moves = get_real_possible_moves(Us, pos, s, attacking);
+            BITBOARD moves = get_real_possible_moves(Us, pos, ei, s, attacking);
             score += PIECE_SCORES.mobility[KNIGHT] * Value(count_bits(moves));
         }
 
@@ -224,8 +330,8 @@ Score score_knights(const Position& pos) {
     return score;
 }
 
-template <ScoreComponent Component, Color Us>
-Score score_bishops(const Position& pos) {
+template <ScoreComponent Component, Color Us, bool WithPsq = true>
+Score score_bishops(const Position& pos, const EvalInfo& ei) {
     constexpr Color Them = ~Us;
     constexpr BITBOARD opp_ranks = opponent_ranks_for(Us);
 
@@ -233,7 +339,7 @@ Score score_bishops(const Position& pos) {
 
     BITBOARD bishops = pos.get_pieces_bb(BISHOP, Us);
 
-    if (Component == SC_MATERIAL || Component == SC_ALL) {
+    if (scores_material<Component, WithPsq>) {
         score +=
             MATERIAL_SCORES.piece_value[BISHOP] * Value(pos.count<BISHOP>(Us));
     }
@@ -242,8 +348,7 @@ Score score_bishops(const Position& pos) {
         return score;
     }
 
-    if ((Component == SC_PIECE_COORDINATION || Component == SC_ALL) &&
-        pos.count<BISHOP>(Us) >= 2) {
+    if (scores_imbalance<Component, WithPsq> && pos.count<BISHOP>(Us) >= 2) {
         score += PIECE_SCORES.bishop_pair;
     }
 
@@ -254,7 +359,7 @@ Score score_bishops(const Position& pos) {
             pos.get_all_pieces_bb() &
             ~(pos.get_pieces_bb(BISHOP, QUEEN) & pos.get_pieces_bb(Us));
 
-        if (PSQT_ENABLED && Component == SC_ALL) {
+        if (scores_psqt<Component, WithPsq>) {
             score += psqt_bonus(BISHOP, s, Us);
         }
 
@@ -264,7 +369,7 @@ Score score_bishops(const Position& pos) {
             score += PIECE_SCORES.control_space[BISHOP] *
                      Value(count_bits(control & opp_ranks));
 
-            BITBOARD moves = get_real_possible_moves(Us, pos, s, attacking);
+            BITBOARD moves = get_real_possible_moves(Us, pos, ei, s, attacking);
             score += PIECE_SCORES.mobility[BISHOP] * Value(count_bits(moves));
 
             // Get the square color of the bishop
@@ -308,15 +413,15 @@ Score score_bishops(const Position& pos) {
     return score;
 }
 
-template <ScoreComponent Component, Color Us>
-Score score_rooks(const Position& pos) {
+template <ScoreComponent Component, Color Us, bool WithPsq = true>
+Score score_rooks(const Position& pos, const EvalInfo& ei) {
     constexpr Color Them = ~Us;
     Score score = 0;
 
     BITBOARD rooks = pos.get_pieces_bb(ROOK, Us);
     BITBOARD opp_ranks = opponent_ranks_for(Us);
 
-    if (Component == SC_MATERIAL || Component == SC_ALL) {
+    if (scores_material<Component, WithPsq>) {
         score += MATERIAL_SCORES.piece_value[ROOK] * Value(pos.count<ROOK>(Us));
     }
 
@@ -333,7 +438,7 @@ Score score_rooks(const Position& pos) {
             pos.get_all_pieces_bb() &
             ~(pos.get_pieces_bb(ROOK, QUEEN) & pos.get_pieces_bb(Us));
 
-        if (PSQT_ENABLED && Component == SC_ALL) {
+        if (scores_psqt<Component, WithPsq>) {
             score += psqt_bonus(ROOK, s, Us);
         }
 
@@ -343,7 +448,7 @@ Score score_rooks(const Position& pos) {
             score += PIECE_SCORES.control_space[ROOK] *
                      Value(count_bits(control_bb & opp_ranks));
 
-            BITBOARD moves = get_real_possible_moves(Us, pos, s, attacking);
+            BITBOARD moves = get_real_possible_moves(Us, pos, ei, s, attacking);
             score += PIECE_SCORES.mobility[ROOK] * Value(count_bits(moves));
 
             // Open/semi-open files bonuses
@@ -391,15 +496,15 @@ Score score_rooks(const Position& pos) {
     return score;
 }
 
-template <ScoreComponent Component, Color Us>
-Score score_queens(const Position& pos) {
+template <ScoreComponent Component, Color Us, bool WithPsq = true>
+Score score_queens(const Position& pos, const EvalInfo& ei) {
     constexpr Color Them = ~Us;
     Score score = 0;
 
     BITBOARD queens = pos.get_pieces_bb(QUEEN, Us);
     BITBOARD opp_ranks = opponent_ranks_for(Us);
 
-    if (Component == SC_MATERIAL || Component == SC_ALL) {
+    if (scores_material<Component, WithPsq>) {
         score +=
             MATERIAL_SCORES.piece_value[QUEEN] * Value(pos.count<QUEEN>(Us));
     }
@@ -411,7 +516,7 @@ Score score_queens(const Position& pos) {
     while (queens) {
         Square s = pop_ls1b(queens);
 
-        if (PSQT_ENABLED && Component == SC_ALL) {
+        if (scores_psqt<Component, WithPsq>) {
             score += psqt_bonus(QUEEN, s, Us);
         }
 
@@ -435,7 +540,7 @@ Score score_queens(const Position& pos) {
 
             // Mobility bonus
             BITBOARD attacking = attacks_bb_by<QUEEN>(s, pos.get_all_pieces_bb());
-            BITBOARD moves = get_real_possible_moves(Us, pos, s, attacking);
+            BITBOARD moves = get_real_possible_moves(Us, pos, ei, s, attacking);
             score += PIECE_SCORES.mobility[QUEEN] * Value(count_bits(moves));
         }
 
@@ -523,26 +628,25 @@ Score score_king_safety(const Position& pos) {
     return score;
 }
 
-template <ScoreComponent Component, Color Us>
-Score score_king(const Position& pos) {
+template <ScoreComponent Component, Color Us, bool WithPsq = true>
+Score score_king(const Position& pos, const EvalInfo& ei) {
     // Both kings must be on the board; a missing king means an illegal
     // position reached the evaluation (e.g. a generated king capture)
     assert(pos.count<KING>(Us) == 1 && pos.count<KING>(~Us) == 1);
 
     const Color Them = ~Us;
     const Square our_ksq = pos.square<KING>(Us);
-    const Square enemy_ksq = pos.square<KING>(Them);
 
     Score score = 0;
 
-    if (PSQT_ENABLED && Component == SC_ALL) {
+    if (scores_psqt<Component, WithPsq>) {
         score += psqt_bonus(KING, our_ksq, Us);
     }
 
     // Account for mobility
     if (Component == SC_MOBILITY || Component == SC_ALL) {
         BITBOARD moves =
-            attacks_bb_by<KING>(our_ksq) & ~pos.get_attacked_squares(Us);
+            ei.attacked_by[Us][KING] & ~ei.attacked_by[Them][ALL_PIECES];
         score += PIECE_SCORES.mobility[KING] * Value(count_bits(moves));
     }
 
@@ -553,7 +657,7 @@ Score score_king(const Position& pos) {
         // Checking for backrank weakness
         const Rank first_rank = rank_relative_to_side(Us, RANK_1);
         const Rank second_rank = rank_relative_to_side(Us, RANK_2);
-        BITBOARD king_area = attacks_bb_by<KING>(our_ksq) | our_ksq;
+        BITBOARD king_area = ei.king_zone[Us];
         BITBOARD their_rook_and_queen =
             pos.get_pieces_bb(ROOK, QUEEN) & pos.get_pieces_bb(Them);
 
@@ -561,17 +665,10 @@ Score score_king(const Position& pos) {
             // Check for backrank weakness
             BITBOARD back_rank_area = king_area & rank_bb(second_rank);
 
-            // Get our pieces and combine them with the minor pieces attacks
-            // This is then combined with opponent's pawn attacks and king
-            // attacks from the enemy king Finally we get a bitboard containing
-            // our pieces, opposite king attacks, minor pieces attacks and
-            // opponent's pawn attacks. Meaning squares that are not available
-            // for our king to move to
+            // Our pieces and every square the opponent attacks, meaning
+            // squares that are not available for our king to move to
             BITBOARD blocked =
-                pos.get_pieces_bb(Us) |
-                (pos.get_attacks_by<KNIGHT>(Them) | pos.get_attacks_by<BISHOP>(Them) |
-                 pos.get_attacks_by<ROOK>(Them) | pos.get_attacks_by<QUEEN>(Them)) |
-                pos.get_attacks_by<PAWN>(Them) | attacks_bb_by<KING>(enemy_ksq);
+                pos.get_pieces_bb(Us) | ei.attacked_by[Them][ALL_PIECES];
 
             if ((back_rank_area & blocked) == back_rank_area) {
                 score += KING_SAFETY_SCORES.weak_back_rank;
@@ -627,21 +724,27 @@ Score score_king(const Position& pos) {
     return score;
 }
 
-// Generates all the material needed
-template <ScoreComponent Component, Color Us>
-Score score_all_material(const Position& pos) {
+// Everything but the pawns, which the pawn table can supply
+template <ScoreComponent Component, Color Us, bool WithPsq = true>
+Score score_pieces(const Position& pos, const EvalInfo& ei) {
     Score score = 0;
 
-    score += score_pawns<Component, Us>(pos);
-    score += score_knights<Component, Us>(pos);
-    score += score_bishops<Component, Us>(pos);
-    score += score_rooks<Component, Us>(pos);
-    score += score_queens<Component, Us>(pos);
-    score += score_king<Component, Us>(pos);
+    score += score_knights<Component, Us, WithPsq>(pos, ei);
+    score += score_bishops<Component, Us, WithPsq>(pos, ei);
+    score += score_rooks<Component, Us, WithPsq>(pos, ei);
+    score += score_queens<Component, Us, WithPsq>(pos, ei);
+    score += score_king<Component, Us, WithPsq>(pos, ei);
 
     return score;
 }
 
+// Generates all the material needed
+template <ScoreComponent Component, Color Us, bool WithPsq = true>
+Score score_all_material(const Position& pos, const EvalInfo& ei) {
+    return score_pawns<Component, Us, WithPsq>(pos) +
+           score_pieces<Component, Us, WithPsq>(pos, ei);
+}
+
 std::string component_type(ScoreComponent c) {
     switch (c) {
         case SC_MATERIAL:
@@ -662,6 +765,18 @@ std::string component_type(ScoreComponent c) {
 }
 }  // namespace
 
+namespace PSQ {
+Score table[PIECE_NB][SQUARE_TOTAL];
+
+void init() {
+    for (Piece p = WHITE_PAWN; p <= BLACK_KING; ++p) {
+        for (Square s = A8; s <= H1; ++s) {
+            table[p][s] = piece_square(p, s);
+        }
+    }
+}
+}  // namespace PSQ
+
 // SC_MATERIAL 				- Gets the material score for the given
 // side SC_MOBILITY 				- Gets the mobility score for
 // the given side SC_KING_SAFETY 			- Gets the king safety
@@ -670,26 +785,96 @@ std::string component_type(ScoreComponent c) {
 // coordination score for the given side SC_ALL
 // - Gets the total score for the given side
 
+const PawnEntry& PawnTable::probe(const Position& pos) {
+    const BITBOARD key = pos.pawn_key();
+    PawnEntry& e = entries[key & (SIZE - 1)];
+
+    ++probes;
+    if (e.key == key) {
+        ++hits;
+        return e;
+    }
+
+    e.key = key;
+    e.passed[WHITE] = e.passed[BLACK] = 0;
+    e.scores[WHITE] =
+        score_pawns<SC_ALL, WHITE, false>(pos, &e.passed[WHITE]);
+    e.scores[BLACK] =
+        score_pawns<SC_ALL, BLACK, false>(pos, &e.passed[BLACK]);
+    e.attacks[WHITE] = pos.get_attacks_by<PAWN>(WHITE);
+    e.attacks[BLACK] = pos.get_attacks_by<PAWN>(BLACK);
+    return e;
+}
+
+const MaterialEntry& MaterialTable::probe(const Position& pos) {
+    const PCV key = pos.material_key();
+    MaterialEntry& e = entries[(key * 0x9E3779B97F4A7C15ULL) >> (64 - BITS)];
+
+    if (e.key == key) {
+        return e;
+    }
+
+    e.key = key;
+    e.endgame = Endgames::find(pos);
+    e.weight = phase_from_scratch(pos);
+    e.imbalance = score_imbalance(pos);
+    return e;
+}
+
 template <ScoreComponent Component>
 Score total_scores(const Position& pos) {
-    return score_all_material<Component, WHITE>(pos) -
-           score_all_material<Component, BLACK>(pos);
+    const EvalInfo ei(pos);
+    return score_all_material<Component, WHITE>(pos, ei) -
+           score_all_material<Component, BLACK>(pos, ei);
 }
 
 template <ScoreComponent T>
 inline Value Scorer<T>::get_score(const Position& pos) {
-    // Get the endgame scores
-    Value endgame = Endgames::score(pos);
+    const MaterialEntry* m = nullptr;
 
-    if (endgame != VALUE_NONE) {
-        return endgame;
-    }
+    // Get the endgame scores, and the game phase weights
+    if (materials != nullptr) {
+        m = &materials->probe(pos);
+        assert(m->endgame == Endgames::find(pos));
 
-    // Get the game phase weights
-    weight = game_phase_weights(pos);
+        if (m->endgame != nullptr) {
+            return m->endgame->score(pos);
+        }
+
+        weight = m->weight;
+    } else {
+        Value endgame = Endgames::score(pos);
+
+        if (endgame != VALUE_NONE) {
+            return endgame;
+        }
 
-    // Get the score for the given component
-    score = total_scores<T>(pos);
+        weight = game_phase_weights(pos);
+    }
+    assert(weight == phase_from_scratch(pos));
+
+    // Get the score for the given component. The full eval starts from the
+    // running material + PSQT sum and adds every other term on top
+    if (T == SC_ALL) {
+        score = INCREMENTAL_PSQ ? pos.psq_score() : psq_from_scratch(pos);
+        assert(!INCREMENTAL_PSQ || score == psq_from_scratch(pos));
+
+        const PawnEntry* e = nullptr;
+        if (pawns != nullptr) {
+            e = &pawns->probe(pos);
+            score += e->scores[WHITE] - e->scores[BLACK];
+        } else {
+            score += score_pawns<T, WHITE, false>(pos) -
+                     score_pawns<T, BLACK, false>(pos);
+        }
+
+        const EvalInfo ei(pos, e);
+        score += score_pieces<T, WHITE, false>(pos, ei) -
+                 score_pieces<T, BLACK, false>(pos, ei);
+        score += m != nullptr ? m->imbalance : score_imbalance(pos);
+    } else {
+        score = total_scores<T>(pos);
+    }
 
     // Combine the score with the weight
     Value v = combine(score, weight);
@@ -704,8 +889,9 @@ inline void Scorer<T>::print_stats(const Position& pos) {
 
     std::cout << pos << std::endl;
 
-    Score w_score = score_all_material<T, WHITE>(pos);
-    Score b_score = score_all_material<T, BLACK>(pos);
+    const EvalInfo ei(pos);
+    Score w_score = score_all_material<T, WHITE>(pos, ei);
+    Score b_score = score_all_material<T, BLACK>(pos, ei);
 
     std::cout
         << std::showpoint << std::noshowpos << std::fixed << std::setprecision(2)
@@ -720,19 +906,19 @@ inline void Scorer<T>::print_stats(const Position& pos) {
         << P((score_pawns<T, WHITE>(pos)), (score_pawns<T, BLACK>(pos)))
         << std::endl
         << "| KNIGHTS |"
-        << P((score_knights<T, WHITE>(pos)), (score_knights<T, BLACK>(pos)))
+        << P((score_knights<T, WHITE>(pos, ei)), (score_knights<T, BLACK>(pos, ei)))
         << std::endl
         << "| BISHOPS |"
-        << P((score_bishops<T, WHITE>(pos)), (score_bishops<T, BLACK>(pos)))
+        << P((score_bishops<T, WHITE>(pos, ei)), (score_bishops<T, BLACK>(pos, ei)))
         << std::endl
         << "|   ROOKS |"
-        << P((score_rooks<T, WHITE>(pos)), (score_rooks<T, BLACK>(pos)))
+        << P((score_rooks<T, WHITE>(pos, ei)), (score_rooks<T, BLACK>(pos, ei)))
         << std::endl
         << "|  QUEENS |"
-        << P((score_queens<T, WHITE>(pos)), (score_queens<T, BLACK>(pos)))
+        << P((score_queens<T, WHITE>(pos, ei)), (score_queens<T, BLACK>(pos, ei)))
         << std::endl
         << "|    KING |"
-        << P((score_king<T, WHITE>(pos)), (score_king<T, BLACK>(pos)))
+        << P((score_king<T, WHITE>(pos, ei)), (score_king<T, BLACK>(pos, ei)))
         << std::endl
         << "+---------+--------------+--------------+--------------+" << std::endl
         << "|   TOTAL |" << P(w_score, b_score) << std::endl
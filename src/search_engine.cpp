@@ -7,20 +7,16 @@
 #include <mutex>
 #include <thread>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define SEARCH_HAS_THREAD_CPUTIME
+#include <time.h>
+#endif
+
+#include "movepick.h"
 #include "thread.h"
 #include "tt.h"
 
 namespace KhaosChess {
-// Move-ordering tiers
-constexpr std::int32_t HISTORY_MAX = 16'000;
-constexpr std::int32_t CONTINUATION_HISTORY_MAX = 16'000;
-constexpr std::int32_t QUIET_SCORE_MAX = HISTORY_MAX + CONTINUATION_HISTORY_MAX;
-constexpr std::int32_t SCORE_COUNTERMOVE = QUIET_SCORE_MAX + 1;
-
-constexpr std::int32_t SCORE_KILLER_SECONDARY = SCORE_COUNTERMOVE + 1;
-constexpr std::int32_t SCORE_KILLER_PRIMARY = SCORE_KILLER_SECONDARY + 1;
-constexpr std::int32_t SCORE_CAPTURE = SCORE_KILLER_PRIMARY + 1;
-
 // Kill-switch (dormant, pending an A/B match). When true, the history/
 // continuation/countermove tables are retained across the moves of a game
 // (Stockfish-style) instead of wiped every search, so move ordering carries
@@ -29,18 +25,6 @@ constexpr std::int32_t SCORE_CAPTURE = SCORE_KILLER_PRIMARY + 1;
 // base to bank it.
 constexpr bool HISTORY_RETENTION = false;
 
-// A capture's ceiling: queen victim + promotion bonus + promoted queen
-constexpr std::int32_t SCORE_PROMOTION_BONUS = 900;
-constexpr std::int32_t CAPTURE_CEILING =
-    SCORE_CAPTURE + (2 * Material().piece_value[QUEEN].mg) +
-    SCORE_PROMOTION_BONUS;
-
-constexpr std::int32_t SCORE_TT_MOVE = CAPTURE_CEILING + 1;
-constexpr std::int32_t SCORE_SKIP = -1'000'000;
-
-// Bad-capture tier
-constexpr std::int32_t SCORE_BAD_CAPTURE = -20'000;
-
 // Null-move pruning
 constexpr std::int32_t NULL_MOVE_REDUCTION = 3;
 constexpr std::int32_t NULL_MOVE_MIN_DEPTH = 3;
@@ -116,6 +100,10 @@ std::atomic<bool> SearchEngine::abort_search{false};
 std::atomic<std::int64_t> SearchEngine::deadline_ms{
     std::numeric_limits<std::int64_t>::max()};
 
+std::atomic<std::int64_t> SearchEngine::cpu_budget_us{0};
+std::atomic<std::int64_t> SearchEngine::cpu_spent_us{0};
+std::atomic<std::uint32_t> SearchEngine::cpu_epoch{0};
+
 // Steady-clock "now" in milliseconds, the unit the shared deadline is kept in.
 static std::int64_t now_ms() {
     return std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -123,6 +111,27 @@ static std::int64_t now_ms() {
         .count();
 }
 
+// CPU time the calling thread has used, in microseconds. Where there is no
+// per-thread CPU clock it stays 0, so a CPU budget never fires there and
+// the deadline or node limit has to end the search.
+static std::int64_t thread_cpu_us() {
+#if defined(SEARCH_HAS_THREAD_CPUTIME)
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#elif defined(_WIN64)
+    FILETIME creation, exit, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+    const auto ticks = [](const FILETIME& ft) {
+        return (static_cast<std::int64_t>(ft.dwHighDateTime) << 32) |
+               ft.dwLowDateTime;
+    };
+    return (ticks(kernel) + ticks(user)) / 10;  // 100 ns units
+#else
+    return 0;
+#endif
+}
+
 void SearchEngine::clear_stop() {
     abort_search.store(false, std::memory_order_relaxed);
 }
@@ -137,6 +146,12 @@ void SearchEngine::ponderhit(std::chrono::milliseconds budget) {
     deadline_ms.store(now_ms() + budget.count(), std::memory_order_relaxed);
 }
 
+void SearchEngine::set_cpu_budget(std::chrono::milliseconds budget) {
+    cpu_spent_us.store(0, std::memory_order_relaxed);
+    cpu_epoch.fetch_add(1, std::memory_order_relaxed);
+    cpu_budget_us.store(budget.count() * 1000, std::memory_order_relaxed);
+}
+
 SearchEngine::SearchEngine(Position& pos, std::int32_t id)
     : pos(pos),
       max_time(std::chrono::milliseconds(3000)),  // Default 3 seconds
@@ -162,6 +177,9 @@ Value SearchEngine::search(std::int32_t depth, SearchInfo& info) {
     start_time = std::chrono::high_resolution_clock::now();
     should_stop = false;
     time_checks = 0;
+    pawn_table.probes = pawn_table.hits = 0;
+    cpu_start_us = cpu_mark_us = thread_cpu_us();
+    cpu_epoch_seen = cpu_epoch.load(std::memory_order_relaxed);
 
     // Arm the shared deadline. While pondering there is none (ponderhit() sets
     // it later); otherwise the hard limit applies from now. Every worker sets
@@ -236,6 +254,10 @@ Value SearchEngine::search(std::int32_t depth, SearchInfo& info) {
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
 
+    info.pawn_probes = pawn_table.probes;
+    info.pawn_hits = pawn_table.hits;
+    info.cpu_time = std::chrono::microseconds(thread_cpu_us() - cpu_start_us);
+
     return best_score;
 }
 
@@ -248,7 +270,7 @@ Value SearchEngine::negamax(std::int32_t depth, std::int32_t ply, Value alpha,
     if (is_time_up()) {
         info.stopped = should_stop = true;
 
-        return Scorer<SC_ALL>().get_score(pos);
+        return Scorer<SC_ALL>(&pawn_table, &material_table).get_score(pos);
     }
 
     info.nodes++;
@@ -281,14 +303,14 @@ Value SearchEngine::negamax(std::int32_t depth, std::int32_t ply, Value alpha,
 
     // Transposition table probe
     bool is_tt_hit;
-    tt::TTEntry* tte = tt::TT.probe(pos.key(), is_tt_hit);
+    tt::TTData tte = tt::TT.probe(pos, is_tt_hit);
 
-    if (is_tt_hit && (ply > 0) && (tte->depth >= depth)) {
-        Value tt_score = score_from_tt(tte->score, ply);
+    if (is_tt_hit && (ply > 0) && (tte.depth >= depth)) {
+        Value tt_score = score_from_tt(tte.score, ply);
 
-        if ((tte->flag() == tt::Flag::F_EXACT) ||
-            ((tte->flag() == tt::Flag::F_LOWER_BOUND) && (tt_score >= beta)) ||
-            ((tte->flag() == tt::Flag::F_UPPER_BOUND) && (tt_score <= alpha))) {
+        if ((tte.flag() == tt::Flag::F_EXACT) ||
+            ((tte.flag() == tt::Flag::F_LOWER_BOUND) && (tt_score >= beta)) ||
+            ((tte.flag() == tt::Flag::F_UPPER_BOUND) && (tt_score <= alpha))) {
             return tt_score;
         }
     }
@@ -296,7 +318,7 @@ Value SearchEngine::negamax(std::int32_t depth, std::int32_t ply, Value alpha,
     // Internal iterative reduction: no TT move at high depth means the node
     // is probably unimportant; search it shallower and let the TT fill in
     if ((depth >= IIR_MIN_DEPTH) &&
-        (!is_tt_hit || (tte->move == Move::invalid_move()))) {
+        (!is_tt_hit || (tte.move == Move::invalid_move()))) {
         depth--;
     }
 
@@ -307,8 +329,18 @@ Value SearchEngine::negamax(std::int32_t depth, std::int32_t ply, Value alpha,
 
     bool is_pv = (beta - alpha) > 1;
 
-    Value static_eval =
-        in_check ? -VALUE_INFINITE : Scorer<SC_ALL>().get_score(pos);
+    Value static_eval = -VALUE_INFINITE;
+    if (!in_check) {
+        static_eval = evaluate(is_tt_hit, tte, info);
+
+        // Remember a fresh eval even if this node is pruned before it stores
+        // a result; a depth -1 entry never displaces a real search result
+        if (!is_tt_hit) {
+            tt::TT.store(pos.key(), VALUE_NONE, -1, tt::Flag::F_NONE,
+                         Move::invalid_move(), static_eval);
+        }
+    }
+    const Value tt_eval = in_check ? VALUE_NONE : static_eval;
 
     // Reverse futility pruning
     if (!is_pv && !in_check && (depth <= RFP_MAX_DEPTH) &&
@@ -329,30 +361,33 @@ Value SearchEngine::negamax(std::int32_t depth, std::int32_t ply, Value alpha,
         }
     }
 
-    // Generate legal moves
-    MoveList<GT_LEGAL> moves(pos);
-
-    // If no legal moves, check for checkmate or stalemate
-    if (moves.size() == 0) {
-        return in_check ? -VALUE_MATE + ply
-                        : VALUE_DRAW;  // Checkmate or Stalemate
+    // Moves come best-first from the picker, generated stage by stage
+    Move counter = Move::invalid_move();
+    const ContinuationTable* continuation = nullptr;
+    if (prev_move != Move::invalid_move()) {
+        // The previous move is already made: its piece sits on its target
+        Square prev_target = prev_move.target_square();
+        counter = countermove[stm][prev_move.source_square()][prev_target];
+        continuation =
+            &continuation_history[pos.get_piece_on(prev_target)][prev_target];
     }
 
-    // Score moves for better ordering
-    score_moves(moves.begin(), moves.end(), ply,
-                is_tt_hit ? tte->move : Move::invalid_move(), true, prev_move);
+    MovePicker picker(pos, is_tt_hit ? tte.move : Move::invalid_move(),
+                      killers[ply], counter, history[stm], continuation);
 
     // Local PV line for this level
     bool found_pv = false;
     Move best_move = Move::invalid_move();
     Move searched_quiets[MAX_MOVES];
+    std::int32_t legal_moves = 0;
     std::int32_t moves_searched = 0;
     std::int32_t num_quiets = 0;
 
     // Loop through all moves
-    for (const ScoredMoves& scored_move : moves) {
-        Move move = scored_move;
+    Move move;
+    while ((move = picker.next_move()) != Move::invalid_move()) {
         MoveInfo move_info;
+        legal_moves++;
 
         // Read before doing a move, while any victim still sits on the target
         bool is_quiet = !is_capture(move) && (move.move_type() != MT_PROMOTION);
@@ -363,7 +398,9 @@ Value SearchEngine::negamax(std::int32_t depth, std::int32_t ply, Value alpha,
             continue;
         }
 
-        // Make the move
+        // Make the move. Late quiets get the prefetch too: the child probes
+        // the table first thing however reduced its search is
+        tt::TT.prefetch(pos.key_after(move));
         pos.do_move(move, move_info);
 
         Value score = pvs_search(depth, ply, alpha, beta, info, moves_searched,
@@ -388,7 +425,7 @@ Value SearchEngine::negamax(std::int32_t depth, std::int32_t ply, Value alpha,
             }
 
             tt::TT.store(pos.key(), score_to_tt(beta, ply), depth,
-                         tt::Flag::F_LOWER_BOUND, move);
+                         tt::Flag::F_LOWER_BOUND, move, tt_eval);
             return beta;
         }
 
@@ -406,9 +443,15 @@ Value SearchEngine::negamax(std::int32_t depth, std::int32_t ply, Value alpha,
         }
     }
 
+    // If no legal moves, check for checkmate or stalemate
+    if (legal_moves == 0) {
+        return in_check ? -VALUE_MATE + ply
+                        : VALUE_DRAW;  // Checkmate or Stalemate
+    }
+
     tt::TT.store(pos.key(), score_to_tt(alpha, ply), depth,
                  found_pv ? tt::Flag::F_EXACT : tt::Flag::F_UPPER_BOUND,
-                 best_move);
+                 best_move, tt_eval);
 
     return alpha;
 }
@@ -431,21 +474,19 @@ Value SearchEngine::quiescence(std::int32_t ply, Value alpha, Value beta,
 
     // Hard safety net for any other pathologically long sequence
     if (ply >= MAX_PLY) {
-        return Scorer<SC_ALL>().get_score(pos);
+        return Scorer<SC_ALL>(&pawn_table, &material_table).get_score(pos);
     }
 
     // Transposition table probe; any stored entry beats a depth-0 search
     bool is_tt_hit = false;
-    tt::TTEntry* tte = nullptr;
-
-    tte = tt::TT.probe(pos.key(), is_tt_hit);
+    tt::TTData tte = tt::TT.probe(pos, is_tt_hit);
 
     if (is_tt_hit) {
-        Value tt_score = score_from_tt(tte->score, ply);
+        Value tt_score = score_from_tt(tte.score, ply);
 
-        if ((tte->flag() == tt::Flag::F_EXACT) ||
-            ((tte->flag() == tt::Flag::F_LOWER_BOUND) && (tt_score >= beta)) ||
-            ((tte->flag() == tt::Flag::F_UPPER_BOUND) && (tt_score <= alpha))) {
+        if ((tte.flag() == tt::Flag::F_EXACT) ||
+            ((tte.flag() == tt::Flag::F_LOWER_BOUND) && (tt_score >= beta)) ||
+            ((tte.flag() == tt::Flag::F_UPPER_BOUND) && (tt_score <= alpha))) {
             return tt_score;
         }
     }
@@ -457,13 +498,16 @@ Value SearchEngine::quiescence(std::int32_t ply, Value alpha, Value beta,
     bool in_check =
         pos.get_attackers_to(pos.square<KING>(stm)) & pos.get_pieces_bb(~stm);
 
+    Value stand_pat = VALUE_NONE;  // also what gets stored as the eval
+
     if (!in_check) {
-        Value stand_pat = Scorer<SC_ALL>().get_score(pos);
+        stand_pat = evaluate(is_tt_hit, tte, info);
 
         // Stand-pat cutoff
         if (stand_pat >= beta) {
             tt::TT.store(pos.key(), score_to_tt(beta, ply), 0,
-                         tt::Flag::F_LOWER_BOUND, Move::invalid_move());
+                         tt::Flag::F_LOWER_BOUND, Move::invalid_move(),
+                         stand_pat);
             return beta;
         }
 
@@ -473,28 +517,19 @@ Value SearchEngine::quiescence(std::int32_t ply, Value alpha, Value beta,
         }
     }
 
-    // Generate only capture moves
-    MoveList<GT_LEGAL> legals(pos);
-
-    // No legal moves while in check is checkmate
-    if (in_check && (legals.size() == 0)) {
-        return -VALUE_MATE + ply;
-    }
-
-    // Score legal moves for better ordering; a quiet TT move is harmless,
-    // the capture filter below skips it anyway
-    score_moves(legals.begin(), legals.end(), ply,
-                is_tt_hit ? tte->move : Move::invalid_move(),
-                false);
+    // Captures and promotions only, unless in check
+    MovePicker picker(pos, is_tt_hit ? tte.move : Move::invalid_move());
+    std::int32_t legal_moves = 0;
 
     // Loop through capture moves
-    for (const ScoredMoves& scored_move : legals) {
-        if (!in_check && !is_capture(scored_move)) {
+    Move move;
+    while ((move = picker.next_move()) != Move::invalid_move()) {
+        legal_moves++;
+
+        if (!in_check && !is_capture(move)) {
             continue;
         }
 
-        Move move = scored_move;
-
         // SEE pruning
         if (!in_check && !pos.see_ge(move, 0)) {
             continue;
@@ -503,6 +538,7 @@ Value SearchEngine::quiescence(std::int32_t ply, Value alpha, Value beta,
         MoveInfo move_info;
 
         // Make the move
+        tt::TT.prefetch(pos.key_after(move));
         pos.do_move(move, move_info);
 
         // Recursively search with negated bounds
@@ -519,7 +555,7 @@ Value SearchEngine::quiescence(std::int32_t ply, Value alpha, Value beta,
         // Beta cutoff (fail-high)
         if (score >= beta) {
             tt::TT.store(pos.key(), score_to_tt(beta, ply), 0,
-                         tt::Flag::F_LOWER_BOUND, move);
+                         tt::Flag::F_LOWER_BOUND, move, stand_pat);
             return beta;
         }
 
@@ -530,84 +566,37 @@ Value SearchEngine::quiescence(std::int32_t ply, Value alpha, Value beta,
         }
     }
 
+    // No legal moves while in check is checkmate
+    if (in_check && (legal_moves == 0)) {
+        return -VALUE_MATE + ply;
+    }
+
     tt::Flag flag =
         (alpha > orig_alpha) ? tt::Flag::F_EXACT : tt::Flag::F_UPPER_BOUND;
-    tt::TT.store(pos.key(), score_to_tt(alpha, ply), 0, flag, best_move);
+    tt::TT.store(pos.key(), score_to_tt(alpha, ply), 0, flag, best_move,
+                 stand_pat);
 
     return alpha;
 }
 
-void SearchEngine::score_moves(ScoredMoves* begin, ScoredMoves* end,
-                               std::int32_t ply, Move tt_move,
-                               bool score_quiets, Move prev_move) {
-    // The previous move is fixed for the whole node, so resolve its inner
-    // continuation-history table once, before the move loop.
-    std::int16_t (*continuation)[SQUARE_TOTAL] = nullptr;
-    if (prev_move != Move::invalid_move()) {
-        // The previous move is already made: its piece sits on its target.
-        Piece prev_piece = pos.get_piece_on(prev_move.target_square());
-        continuation =
-            continuation_history[prev_piece][prev_move.target_square()];
+// The eval is a pure function of the position, so any TT entry for this key
+// that carries one (even too shallow for a cutoff) saves the full Scorer
+// pass, endgame scan included
+Value SearchEngine::evaluate(bool is_tt_hit, const tt::TTData& tte,
+                             SearchInfo& info) {
+    if (is_tt_hit && (tte.eval != VALUE_NONE)) {
+        info.evals_saved++;
+        return tte.eval;
     }
 
-    // Simple move ordering with MVV-LVA
-    for (ScoredMoves* it = begin; it != end; ++it) {
-        Move move = *it;
-
-        if (move == tt_move) {
-            it->score = SCORE_TT_MOVE;
-            continue;
-        }
-
-        // Captures and promotions
-        if (is_capture(move) || (move.move_type() == MT_PROMOTION)) {
-            PieceType victim =
-                type_of_piece(pos.get_piece_on(move.target_square()));
-            PieceType aggressor =
-                type_of_piece(pos.get_piece_on(move.source_square()));
-
-            bool is_winning = pos.see_ge(move, 0);
-
-            it->score = (is_winning ? SCORE_CAPTURE : SCORE_BAD_CAPTURE) +
-                        MATERIAL_SCORES.piece_value[victim].mg -
-                        MATERIAL_SCORES.piece_value[aggressor].mg / 10;
-
-            if (move.move_type() == MT_PROMOTION) {
-                it->score += SCORE_PROMOTION_BONUS +
-                             MATERIAL_SCORES.piece_value[move.promoted()].mg;
-            }
-        } else if (score_quiets) {
-            if (move == killers[ply][0]) {
-                it->score = SCORE_KILLER_PRIMARY;
-            } else if (move == killers[ply][1]) {
-                it->score = SCORE_KILLER_SECONDARY;
-            } else if ((prev_move != Move::invalid_move()) &&
-                       (move == countermove[pos.side_to_move()]
-                                           [prev_move.source_square()]
-                                           [prev_move.target_square()])) {
-                it->score = SCORE_COUNTERMOVE;
-            } else {
-                Piece current = pos.get_piece_on(move.source_square());
-
-                std::int32_t ch =
-                    (continuation != nullptr)
-                        ? continuation[current][move.target_square()]
-                        : 0;
-                it->score = history[pos.side_to_move()][move.source_square()]
-                                   [move.target_square()] +
-                            ch;
-            }
-        } else {
-            // Quiescence discards quiets (except evasions)
-            it->score = SCORE_SKIP;
-        }
-    }
-
-    std::sort(begin, end, [](auto& a, auto& b) { return a.score > b.score; });
+    info.evals++;
+    return Scorer<SC_ALL>(&pawn_table, &material_table).get_score(pos);
 }
 
+// Castling is encoded as king-takes-own-rook, so its target is occupied
 bool SearchEngine::is_capture(Move move) {
-    return (pos.get_piece_on(move.target_square()) != NO_PIECE) ||
+    return ((move.move_type() != MT_CASTLING) &&
+            (pos.get_piece_on(move.target_square()) != NO_PIECE)) ||
            (move.move_type() == MT_EN_PASSANT);
 }
 
@@ -640,6 +629,23 @@ bool SearchEngine::is_time_up() {
         return should_stop = true;
     }
 
+    // Add what this thread has burnt since its last poll to the shared CPU
+    // total; whichever worker takes it past the budget stops them all
+    const std::int64_t cpu_budget =
+        cpu_budget_us.load(std::memory_order_relaxed);
+    if (cpu_budget > 0) {
+        const std::int64_t now = thread_cpu_us();
+        const std::uint32_t epoch = cpu_epoch.load(std::memory_order_relaxed);
+        const std::int64_t used = epoch == cpu_epoch_seen ? now - cpu_mark_us : 0;
+        cpu_mark_us = now;
+        cpu_epoch_seen = epoch;
+        if (cpu_spent_us.fetch_add(used, std::memory_order_relaxed) + used >=
+            cpu_budget) {
+            abort_search.store(true, std::memory_order_relaxed);
+            return should_stop = true;
+        }
+    }
+
     return false;
 }
 
@@ -846,7 +852,8 @@ void SearchEngine::report_iteration(const SearchInfo& info, std::int32_t depth,
     }
 
     std::cout << " nodes " << (info.nodes + info.q_nodes) << " time "
-              << info.time.count() << " pv";
+              << info.time.count() << " hashfull " << tt::TT.hashfull()
+              << " pv";
 
     for (const Move& m : info.pv) {
         std::cout << " " << m.uci_move();
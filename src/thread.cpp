@@ -1,6 +1,8 @@
 #include "thread.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <iostream>
 
 #include "tt.h"
 
@@ -35,23 +37,30 @@ ThreadPool::~ThreadPool() {
     kill_workers();
 }
 
-// A parked worker waits here for run() to arm it, runs one search, then parks
-// again. It only touches its own board/engine/result, so no locking is needed
-// during the search itself; the mutex just guards the searching/exit flags.
+// A parked worker waits here for run() or run_on_workers() to arm it, runs
+// one search or job, then parks again. It only touches its own
+// board/engine/result, so no locking is needed during the search itself; the
+// mutex just guards the busy/exit flags.
 void ThreadPool::idle_loop(Worker* w) {
     while (true) {
         std::unique_lock<std::mutex> lk(mtx_);
-        cv_.wait(lk, [&] { return w->searching || exit_; });
+        cv_.wait(lk, [&] { return w->busy || exit_; });
         if (exit_) {
             return;
         }
         std::int32_t depth = limits_.depth;
+        const Job* job = job_;
+        std::size_t count = workers_.size();
         lk.unlock();
 
-        w->engine->search(depth, w->result);
+        if (job) {
+            (*job)(static_cast<std::size_t>(w->id), count);
+        } else {
+            w->engine->search(depth, w->result);
+        }
 
         lk.lock();
-        w->searching = false;
+        w->busy = false;
         done_cv_.notify_all();
     }
 }
@@ -89,6 +98,29 @@ void ThreadPool::kill_workers() {
     exit_ = false;
 }
 
+void ThreadPool::run_on_workers(const Job& job) {
+    ensure_workers();
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        job_ = &job;
+        for (auto& w : workers_) {
+            w->busy = true;
+        }
+    }
+    cv_.notify_all();
+
+    std::unique_lock<std::mutex> lk(mtx_);
+    done_cv_.wait(lk, [&] {
+        for (auto& w : workers_) {
+            if (w->busy) {
+                return false;
+            }
+        }
+        return true;
+    });
+    job_ = nullptr;
+}
+
 void ThreadPool::clear_history() {
     // Called on ucinewgame, between games, so no search is in flight.
     for (auto& w : workers_) {
@@ -101,11 +133,15 @@ SearchInfo ThreadPool::run(Position& root, const SearchLimits& limits) {
     tt::TT.new_search();  // one generation bump per search, shared by all workers
 
     std::string root_fen = root.get_fen();
+    const auto start = std::chrono::steady_clock::now();
 
     // Arm every worker on the same root, then wake them together.
     {
         std::unique_lock<std::mutex> lk(mtx_);
         limits_ = limits;
+        // A ponder search has no CPU budget until ponderhit arms it
+        SearchEngine::set_cpu_budget(limits.ponder ? std::chrono::milliseconds(0)
+                                                   : limits.cpu_time);
         for (auto& w : workers_) {
             w->pos.set(root_fen, &w->mi);
             w->engine->set_max_time(limits.max_time);
@@ -116,7 +152,7 @@ SearchInfo ThreadPool::run(Position& root, const SearchLimits& limits) {
             w->engine->set_ponder(limits.ponder);
             w->engine->set_max_nodes(limits.node_limit);
             w->result = SearchInfo();
-            w->searching = true;
+            w->busy = true;
         }
     }
     cv_.notify_all();
@@ -125,14 +161,14 @@ SearchInfo ThreadPool::run(Position& root, const SearchLimits& limits) {
     // ignore the soft budget and would otherwise run on to the hard limit.
     {
         std::unique_lock<std::mutex> lk(mtx_);
-        done_cv_.wait(lk, [&] { return !workers_[0]->searching; });
+        done_cv_.wait(lk, [&] { return !workers_[0]->busy; });
     }
     SearchEngine::stop();
     {
         std::unique_lock<std::mutex> lk(mtx_);
         done_cv_.wait(lk, [&] {
             for (auto& w : workers_) {
-                if (w->searching) {
+                if (w->busy) {
                     return false;
                 }
             }
@@ -148,6 +184,48 @@ SearchInfo ThreadPool::run(Position& root, const SearchLimits& limits) {
 
     std::size_t best = pick_best_thread(results);
 
+    // Nodes, static evals computed vs. reused from the TT, pawn table hits
+    // and CPU time, summed over all workers
+    totals_ = SearchInfo();
+    totals_.time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    for (const SearchInfo& r : results) {
+        totals_.nodes += r.nodes;
+        totals_.q_nodes += r.q_nodes;
+        totals_.evals += r.evals;
+        totals_.evals_saved += r.evals_saved;
+        totals_.pawn_probes += r.pawn_probes;
+        totals_.pawn_hits += r.pawn_hits;
+        totals_.cpu_time += r.cpu_time;
+    }
+    // Diagnostics, printed only with the TTStats option on: static evals
+    // computed and reused from the TT, pawn table hits, CPU time
+    // against wall time (about the worker count when every worker had a
+    // core to itself, less when they were starved or left idle) and the
+    // TT counters
+    if (tt::TT.stats_on()) {
+        const std::uint64_t evals = totals_.evals;
+        const std::uint64_t evals_saved = totals_.evals_saved;
+        const std::int64_t cpu_ms = totals_.cpu_time.count() / 1000;
+        {
+            std::lock_guard<std::mutex> io_lock(io_mutex);
+            std::cout << "info string evals " << evals << " saved "
+                      << evals_saved << " ("
+                      << (evals_saved * 100 /
+                          std::max<std::uint64_t>(evals + evals_saved, 1))
+                      << "%) pawn hits "
+                      << (totals_.pawn_hits * 100 /
+                          std::max<std::uint64_t>(totals_.pawn_probes, 1))
+                      << "%\n"
+                      << "info string cputime " << cpu_ms << " wall "
+                      << totals_.time.count() << " ("
+                      << (cpu_ms * 100 /
+                          std::max<std::int64_t>(totals_.time.count(), 1))
+                      << "%)\n";
+        }
+        tt::TT.print_stats();
+    }
+
     // Only the main worker reports info lines during the search. If a helper
     // won the vote, its PV was never printed, so emit a final info line for it
     // now — otherwise the GUI's last PV would not match the bestmove we play.
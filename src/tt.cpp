@@ -1,85 +1,646 @@
 #include "tt.h"
 
 #include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TT_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "position.h"
+#include "score.h"
+#include "thread.h"
+#include "zobrist.h"
 
 namespace KhaosChess {
 namespace tt {
 
 TranspositionTable TT;
 
-void TranspositionTable::resize(std::size_t mb) {
-    const std::size_t count = mb * 1024 * 1024 / sizeof(Cluster);
+namespace {
+constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
 
-    // round down to a power of two so that (key & mask) is a valid index
-    std::size_t pow2 = 1;
-    while (pow2 * 2 <= count) {
-        pow2 *= 2;
+// On Linux the table is 2MB aligned and flagged for transparent huge pages,
+// so a multi-GB table costs a few thousand TLB entries instead of a million
+// 4KB ones. If the kernel refuses (THP disabled, old kernel) the memory is
+// still usable with normal pages; other platforms get a plain aligned block.
+void* alloc_large(std::size_t size, bool& huge) {
+    huge = false;
+    void* mem = nullptr;
+
+#if defined(__linux__)
+    size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    mem = std::aligned_alloc(HUGE_PAGE_SIZE, size);
+#if defined(MADV_HUGEPAGE)
+    if (mem) {
+        huge = madvise(mem, size, MADV_HUGEPAGE) == 0;
     }
+#endif
+#else
+    mem = ::operator new(size, std::align_val_t(alignof(Cluster)), std::nothrow);
+#endif
+
+    if (!mem) {
+        throw std::bad_alloc();
+    }
+    return mem;
+}
+
+void free_large(void* mem) {
+#if defined(__linux__)
+    std::free(mem);
+#else
+    ::operator delete(mem, std::align_val_t(alignof(Cluster)));
+#endif
+}
+
+// Saved table files. Bump the version with any change to the Cluster
+// layout or the meaning of its fields, so older files are rejected
+constexpr char FILE_MAGIC[8] = {'K', 'H', 'A', 'O', 'S', 'T', 'T', '\0'};
+constexpr std::uint32_t FILE_VERSION = 2;
+
+// The header is padded to a page so the clusters of a mapped file start
+// page (and so cache-line) aligned
+constexpr std::size_t FILE_HEADER_SIZE = 4096;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t cluster_size;
+    std::uint64_t zobrist_seed;
+    std::uint64_t cluster_count;
+    std::uint8_t generation;
+};
+
+static_assert(sizeof(FileHeader) <= FILE_HEADER_SIZE,
+              "file header must fit its padding");
+
+bool check_header(const FileHeader& h, std::uint64_t file_size,
+                  std::string& error) {
+    if (std::memcmp(h.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        error = "not a KhaosChess hash file";
+    } else if (h.version != FILE_VERSION || h.cluster_size != sizeof(Cluster)) {
+        error = "hash file has entry format version " +
+                std::to_string(h.version) + ", expected " +
+                std::to_string(FILE_VERSION);
+    } else if (h.zobrist_seed != Zobrist::SEED) {
+        error = "hash file was written with a different Zobrist seed";
+    } else if (h.cluster_count == 0 || file_size < FILE_HEADER_SIZE ||
+               h.cluster_count >
+                   (file_size - FILE_HEADER_SIZE) / sizeof(Cluster) ||
+               file_size != FILE_HEADER_SIZE + h.cluster_count * sizeof(Cluster)) {
+        // Bounded before the multiply, so a huge count cannot wrap around
+        // to the file size
+        error = "hash file size does not match its header";
+    } else {
+        return true;
+    }
+    return false;
+}
+
+constexpr std::int32_t DEPTH_OFFSET = -2;  // stored depth byte 0 = empty
 
-    clusters.assign(pow2, Cluster{});
-    mask = pow2 - 1;
+std::uint32_t key32(BITBOARD key) {
+    return static_cast<std::uint32_t>(key);
+}
+
+std::uint32_t fold32(std::uint64_t data) {
+    return static_cast<std::uint32_t>(data ^ (data >> 32));
+}
+
+// Scores and evals are stored as 24-bit two's complement, which covers
+// +/-VALUE_INFINITE with room to spare
+std::uint64_t pack24(Value v) {
+    assert(v >= -(1 << 23) && v < (1 << 23));
+    return static_cast<std::uint32_t>(v) & 0xFFFFFF;
+}
+
+Value unpack24(std::uint64_t bits) {
+    return static_cast<Value>(static_cast<std::uint32_t>(bits << 8)) >> 8;
+}
+
+std::uint64_t pack_data(Move move, Value score, Value eval) {
+    return move.move_value() | (pack24(score) << 16) | (pack24(eval) << 40);
+}
+
+std::uint64_t pack_aux(BITBOARD key, std::uint64_t data, std::int32_t depth,
+                       std::uint8_t gen_flag) {
+    return (static_cast<std::uint64_t>(key32(key) ^ fold32(data)) << 32) |
+           (static_cast<std::uint64_t>(depth - DEPTH_OFFSET) << 8) | gen_flag;
+}
+
+std::int32_t aux_depth(std::uint64_t aux) {
+    return static_cast<std::int32_t>((aux >> 8) & 0xFF) + DEPTH_OFFSET;
+}
+
+std::uint8_t aux_gen_flag(std::uint64_t aux) {
+    return static_cast<std::uint8_t>(aux);
+}
+
+bool aux_empty(std::uint64_t aux) {
+    return ((aux >> 8) & 0xFF) == 0;
+}
+
+TTData unpack(std::uint64_t data, std::uint64_t aux) {
+    TTData d;
+    d.move = Move(static_cast<std::uint16_t>(data));
+    d.score = unpack24(data >> 16);
+    d.eval = unpack24(data >> 40);
+    d.depth = static_cast<std::int8_t>(aux_depth(aux));
+    d.gen_flag = aux_gen_flag(aux);
+    return d;
+}
+
+// Both words use relaxed ordering: the key check, not the memory model, is
+// what rejects an aux and data word that came from different stores.
+bool read_entry(const Cluster& c, int i, BITBOARD key, std::uint64_t& data,
+                std::uint64_t& aux) {
+    aux = c.aux[i].load(std::memory_order_relaxed);
+    if (aux_empty(aux)) {
+        return false;
+    }
+    data = c.data[i].load(std::memory_order_relaxed);
+    return (aux >> 32) == (key32(key) ^ fold32(data));
+}
+}  // namespace
+
+// First page of a shared segment: the same identity fields as a saved file,
+// plus the bookkeeping the attached processes share
+struct TranspositionTable::SharedHeader {
+    FileHeader info;
+    std::atomic<std::uint32_t> ready;  // creator has written info
+    std::atomic<std::uint32_t> users;  // attached processes
+    std::atomic<std::uint32_t> generation;
+};
+
+TranspositionTable::~TranspositionTable() {
+    release();
+}
+
+void TranspositionTable::release() {
+#if defined(TT_HAS_MMAP)
+    if (shared) {
+        // The last process out removes the name; the memory itself goes
+        // away with the final munmap
+        if (shared->users.fetch_sub(1) == 1) {
+            shm_unlink(shared_name.c_str());
+        }
+        shared = nullptr;
+        shared_name.clear();
+    }
+    if (mapping) {
+        munmap(mapping, mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+        clusters = nullptr;
+    }
+#endif
+    free_large(clusters);
+    clusters = nullptr;
+    cluster_count = 0;
+    loaded = false;
+}
+
+void TranspositionTable::resize(std::size_t mb) {
+    // cluster_index() handles any count, so no rounding to a power of two
+    const std::size_t count =
+        std::max<std::size_t>(1, mb * 1024 * 1024 / sizeof(Cluster));
+
+    release();  // leaves the table empty if the allocation throws
+
+    clusters = static_cast<Cluster*>(
+        alloc_large(count * sizeof(Cluster), huge_pages_));
+    cluster_count = count;
+
+    clear();
 }
 
 void TranspositionTable::clear() {
-    std::fill(clusters.begin(), clusters.end(), Cluster{});
+    if (shared) {
+        return;
+    }
+
+    // Each worker zeroes its own slice; this also makes the first touch of
+    // fresh pages happen on the threads that will search them
+    Threads.run_on_workers([this](std::size_t idx, std::size_t count) {
+        const std::size_t stride = cluster_count / count;
+        const std::size_t start = stride * idx;
+        const std::size_t len =
+            (idx + 1 == count) ? cluster_count - start : stride;
+
+        // An all-zero aux word marks an empty slot
+        std::memset(static_cast<void*>(clusters + start), 0,
+                    len * sizeof(Cluster));
+    });
     generation = 0;
 }
 
+bool TranspositionTable::save(const std::string& path,
+                              std::string& error) const {
+    FileHeader h{};
+    std::memcpy(h.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    h.version = FILE_VERSION;
+    h.cluster_size = sizeof(Cluster);
+    h.zobrist_seed = Zobrist::SEED;
+    h.cluster_count = cluster_count;
+    h.generation = generation;
+
+    char header[FILE_HEADER_SIZE] = {};
+    std::memcpy(header, &h, sizeof(h));
+
+    // Write a temporary file and rename it over the target: the target may
+    // be the very file this table is mapped from, which must not be
+    // truncated underneath the mapping
+    const std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) {
+        error = "cannot open " + tmp + ": " + std::strerror(errno);
+        return false;
+    }
+
+    bool ok = std::fwrite(header, 1, sizeof(header), f) == sizeof(header) &&
+              std::fwrite(static_cast<const void*>(clusters), sizeof(Cluster),
+                          cluster_count, f) == cluster_count;
+    ok = (std::fclose(f) == 0) && ok;
+
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        error = "cannot write " + path + ": " + std::strerror(errno);
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool TranspositionTable::load(const std::string& path, std::string& error) {
+    FileHeader h{};
+
+#if defined(TT_HAS_MMAP)
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st{};
+    if (fd < 0 || fstat(fd, &st) != 0 ||
+        pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h))) {
+        error = "cannot read " + path + ": " + std::strerror(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+
+    const std::uint64_t file_size = static_cast<std::uint64_t>(st.st_size);
+    if (!check_header(h, file_size, error)) {
+        close(fd);
+        return false;
+    }
+
+    // MAP_PRIVATE: the search writes into its own copy-on-write pages and
+    // the file stays as it was saved. Nothing is read until a page is hit
+    void* map = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                     fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    madvise(map, file_size, MADV_RANDOM);  // TT access has no locality
+
+    release();
+    mapping = map;
+    mapping_size = file_size;
+    huge_pages_ = false;
+    clusters = reinterpret_cast<Cluster*>(static_cast<char*>(map) +
+                                          FILE_HEADER_SIZE);
+#else
+    // No mmap: read the clusters into a normal allocation instead
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f || std::fread(&h, sizeof(h), 1, f) != 1 ||
+        std::fseek(f, 0, SEEK_END) != 0) {
+        error = "cannot read " + path;
+        if (f) {
+            std::fclose(f);
+        }
+        return false;
+    }
+
+    const std::uint64_t file_size = static_cast<std::uint64_t>(std::ftell(f));
+    if (!check_header(h, file_size, error)) {
+        std::fclose(f);
+        return false;
+    }
+
+    release();
+    clusters = static_cast<Cluster*>(
+        alloc_large(h.cluster_count * sizeof(Cluster), huge_pages_));
+    bool ok = std::fseek(f, FILE_HEADER_SIZE, SEEK_SET) == 0 &&
+              std::fread(static_cast<void*>(clusters), sizeof(Cluster),
+                         h.cluster_count, f) == h.cluster_count;
+    std::fclose(f);
+    if (!ok) {
+        error = "cannot read " + path;
+        resize(1);  // never leave the table without storage
+        return false;
+    }
+#endif
+
+    cluster_count = static_cast<std::size_t>(h.cluster_count);
+    generation = h.generation;
+    loaded = true;
+    return true;
+}
+
+bool TranspositionTable::attach_shared(const std::string& name, std::size_t mb,
+                                       std::string& error) {
+    static_assert(sizeof(SharedHeader) <= FILE_HEADER_SIZE,
+                  "shared header must fit its padding");
+
+#if defined(TT_HAS_MMAP)
+    if (name.empty()) {
+        error = "no shared memory name given";
+        return false;
+    }
+    const std::string shm_name = name.front() == '/' ? name : "/" + name;
+
+    // Exactly one process wins the exclusive create and initializes the
+    // header; a fresh segment is zero-filled, i.e. an empty table
+    bool creator = true;
+    int fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        creator = false;
+        fd = shm_open(shm_name.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        error = "cannot open shared memory " + shm_name + ": " +
+                std::strerror(errno);
+        return false;
+    }
+
+    std::uint64_t size = 0;
+    if (creator) {
+        const std::uint64_t count =
+            std::max<std::size_t>(1, mb * 1024 * 1024 / sizeof(Cluster));
+        size = FILE_HEADER_SIZE + count * sizeof(Cluster);
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            error = "cannot size shared memory " + shm_name + ": " +
+                    std::strerror(errno);
+            close(fd);
+            shm_unlink(shm_name.c_str());
+            return false;
+        }
+    } else {
+        // The creator may not have sized the segment yet
+        for (int tries = 0; size == 0 && tries < 1000; tries++) {
+            struct stat st{};
+            if (fstat(fd, &st) == 0 && st.st_size > 0) {
+                size = static_cast<std::uint64_t>(st.st_size);
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    void* map = size ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                            fd, 0)
+                     : MAP_FAILED;
+    close(fd);
+    if (map == MAP_FAILED) {
+        error = "cannot map shared memory " + shm_name;
+        return false;
+    }
+
+    auto* header = static_cast<SharedHeader*>(map);
+    if (creator) {
+        FileHeader& h = header->info;
+        std::memcpy(h.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        h.version = FILE_VERSION;
+        h.cluster_size = sizeof(Cluster);
+        h.zobrist_seed = Zobrist::SEED;
+        h.cluster_count = (size - FILE_HEADER_SIZE) / sizeof(Cluster);
+        header->users.store(1);
+        header->ready.store(1, std::memory_order_release);
+    } else {
+        for (int tries = 0;
+             !header->ready.load(std::memory_order_acquire) && tries < 1000;
+             tries++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (!header->ready.load(std::memory_order_acquire) ||
+            !check_header(header->info, size, error)) {
+            if (error.empty()) {
+                error = "shared memory " + shm_name + " was never initialized";
+            }
+            munmap(map, size);
+            return false;
+        }
+        header->users.fetch_add(1);
+    }
+
+    release();
+    mapping = map;
+    mapping_size = size;
+    shared = header;
+    shared_name = shm_name;
+    clusters = reinterpret_cast<Cluster*>(static_cast<char*>(map) +
+                                          FILE_HEADER_SIZE);
+    cluster_count = static_cast<std::size_t>(header->info.cluster_count);
+    generation = header->generation.load() & 0x3F;
+    huge_pages_ = false;
+    return true;
+#else
+    (void)name;
+    (void)mb;
+    error = "shared memory tables need POSIX shm_open";
+    return false;
+#endif
+}
+
 void TranspositionTable::new_search() {
-    generation = (generation + 1) & 0x3F;
+    if (shared) {
+        generation = (shared->generation.fetch_add(1) + 1) & 0x3F;
+    } else {
+        generation = (generation + 1) & 0x3F;
+    }
+
+    if (stats_enabled) {
+        for (auto* c : {&counters.probes, &counters.hits, &counters.collisions,
+                        &counters.fills, &counters.updates,
+                        &counters.evict_age, &counters.evict_depth}) {
+            c->store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::int32_t TranspositionTable::hashfull() const {
+    const std::size_t sample =
+        std::min<std::size_t>(cluster_count, 1000 / Cluster::ENTRIES);
+    std::int32_t used = 0;
+
+    for (std::size_t i = 0; i < sample; i++) {
+        for (int j = 0; j < Cluster::ENTRIES; j++) {
+            std::uint64_t aux =
+                clusters[i].aux[j].load(std::memory_order_relaxed);
+            used += !aux_empty(aux) && ((aux_gen_flag(aux) >> 2) == generation);
+        }
+    }
+
+    return static_cast<std::int32_t>(used * 1000 /
+                                     (sample * Cluster::ENTRIES));
 }
 
-TTEntry* TranspositionTable::probe(BITBOARD key, bool& is_found) {
-    Cluster& c = clusters[key & mask];
+void TranspositionTable::print_stats() const {
+    const TTStats s = stats();
+    const std::uint64_t pct = s.probes ? s.hits * 100 / s.probes : 0;
+
+    std::lock_guard<std::mutex> io_lock(io_mutex);
+    std::cout << "info string tt hashfull " << hashfull() << " probes "
+              << s.probes << " hits " << s.hits << " (" << pct
+              << "%) collisions " << s.collisions << " fills " << s.fills
+              << " updates " << s.updates << " evict_age " << s.evict_age
+              << " evict_depth " << s.evict_depth << "\n";
+}
+
+TTStats TranspositionTable::stats() const {
+    TTStats s;
+    s.probes = counters.probes.load(std::memory_order_relaxed);
+    s.hits = counters.hits.load(std::memory_order_relaxed);
+    s.collisions = counters.collisions.load(std::memory_order_relaxed);
+    s.fills = counters.fills.load(std::memory_order_relaxed);
+    s.updates = counters.updates.load(std::memory_order_relaxed);
+    s.evict_age = counters.evict_age.load(std::memory_order_relaxed);
+    s.evict_depth = counters.evict_depth.load(std::memory_order_relaxed);
+    return s;
+}
+
+TTData TranspositionTable::probe(BITBOARD key, bool& is_found) {
+    Cluster& c = clusters[cluster_index(key)];
+
+    for (int i = 0; i < Cluster::ENTRIES; i++) {
+        std::uint64_t data;
+        std::uint64_t aux;
+        if (read_entry(c, i, key, data, aux)) {
+            // refresh the age so entries the search still visits stay
+            // senior; the key check does not cover gen_flag, so only the
+            // aux word needs rewriting
+            std::uint8_t gen_flag = static_cast<std::uint8_t>(
+                (generation << 2) | (aux_gen_flag(aux) & 0x3));
+            aux = (aux & ~std::uint64_t(0xFF)) | gen_flag;
+            c.aux[i].store(aux, std::memory_order_relaxed);
+
+            if (stats_enabled) {
+                count(counters.probes);
+                count(counters.hits);
+            }
 
-    for (TTEntry& e : c.entry) {
-        if (e.key == key) {
-            // refresh the age so entries the search still visits stay senior
-            e.gen_flag =
-                static_cast<std::uint8_t>((generation << 2) | (e.gen_flag & 0x3));
             is_found = true;
-            return &e;
+            return unpack(data, aux);
+        }
+    }
+
+    if (stats_enabled) {
+        count(counters.probes);
+
+        bool full = true;
+        for (int i = 0; i < Cluster::ENTRIES; i++) {
+            full &= !aux_empty(c.aux[i].load(std::memory_order_relaxed));
+        }
+        if (full) {
+            count(counters.collisions);
         }
     }
 
     is_found = false;
-    return nullptr;
+    return TTData{};
+}
+
+TTData TranspositionTable::probe(const Position& pos, bool& is_found) {
+    TTData d = probe(pos.key(), is_found);
+
+    if (is_found &&
+        (((d.move != Move::invalid_move()) && !pos.is_pseudo_legal(d.move)) ||
+         ((d.eval != VALUE_NONE) &&
+          ((d.eval <= -VALUE_MATE) || (d.eval >= VALUE_MATE))))) {
+        is_found = false;
+        return TTData{};
+    }
+    return d;
 }
 
 void TranspositionTable::store(BITBOARD key, Value score, std::int32_t depth,
-                               Flag flag, Move move) {
-    Cluster& c = clusters[key & mask];
+                               Flag flag, Move move, Value eval) {
+    Cluster& c = clusters[cluster_index(key)];
 
     // Same position already stored: update that entry in place
-    TTEntry* victim = nullptr;
-    for (TTEntry& e : c.entry) {
-        if (e.key == key) {
-            victim = &e;
+    int victim = -1;
+    for (int i = 0; i < Cluster::ENTRIES; i++) {
+        std::uint64_t data;
+        std::uint64_t aux;
+        if (read_entry(c, i, key, data, aux)) {
+            victim = i;
+            TTData old = unpack(data, aux);
+            if (move == Move::invalid_move()) {
+                move = old.move;  // a moveless update must not erase a move
+            }
+            if (eval == VALUE_NONE) {
+                eval = old.eval;
+            }
             break;
         }
     }
 
-    if (victim == nullptr) {
+    if (victim < 0) {
         // Evict the least valuable entry: shallower loses to deeper, and
-        // every generation of staleness costs eight plies of seniority
-        auto value = [this](const TTEntry& e) {
-            std::int32_t age = (generation - e.generation()) & 0x3F;
-            return static_cast<std::int32_t>(e.depth) - 8 * age;
+        // every generation of staleness costs eight plies of seniority.
+        // Depth and age both live in the aux word, so no data is read.
+        auto value = [this, &c](int i) {
+            std::uint64_t aux = c.aux[i].load(std::memory_order_relaxed);
+            std::int32_t age = (generation - (aux_gen_flag(aux) >> 2)) & 0x3F;
+            return aux_depth(aux) - 8 * age;
         };
 
-        victim = &c.entry[0];
-        for (TTEntry& e : c.entry) {
-            if (value(e) < value(*victim)) {
-                victim = &e;
+        victim = 0;
+        std::int32_t victim_value = value(0);
+        for (int i = 1; i < Cluster::ENTRIES; i++) {
+            std::int32_t v = value(i);
+            if (v < victim_value) {
+                victim = i;
+                victim_value = v;
+            }
+        }
+
+        if (stats_enabled) {
+            std::uint64_t aux = c.aux[victim].load(std::memory_order_relaxed);
+            if (aux_empty(aux)) {
+                count(counters.fills);
+            } else if ((aux_gen_flag(aux) >> 2) != generation) {
+                count(counters.evict_age);
+            } else {
+                count(counters.evict_depth);
             }
         }
-    } else if (move == Move::invalid_move()) {
-        move = victim->move;  // a moveless update must not erase a known move
+    } else if (stats_enabled) {
+        count(counters.updates);
     }
 
-    *victim = {key, score, move, static_cast<std::int8_t>(depth),
-               static_cast<std::uint8_t>((generation << 2) |
-                                         static_cast<std::uint8_t>(flag))};
+    assert(depth > DEPTH_OFFSET && depth - DEPTH_OFFSET <= 0xFF);
+
+    std::uint64_t data = pack_data(move, score, eval);
+    std::uint8_t gen_flag = static_cast<std::uint8_t>(
+        (generation << 2) | static_cast<std::uint8_t>(flag));
+
+    c.data[victim].store(data, std::memory_order_relaxed);
+    c.aux[victim].store(pack_aux(key, data, depth, gen_flag),
+                        std::memory_order_relaxed);
 }
 
 }  // namespace tt
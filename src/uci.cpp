@@ -2,11 +2,13 @@
 
 #include <stdlib.h>
 #include <algorithm>
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <mutex>
 #include <thread>
 
+#include "bench.h"
 #include "move.h"
 #include "movegen.h"
 #include "perft.h"
@@ -120,8 +122,15 @@ void parse_position(const char* cmd, Position& pos, InfoListPtr& infos) {
 bool parse_go(const char* cmd, Position& pos, SearchLimits& limits) {
     const char* current;
 
+    // "go perft <depth> [hash <MB>]": divide on the Threads workers, with
+    // bulk counting and an optional perft hash
     if ((current = strstr(cmd, "perft"))) {
-        perft_debug(pos, atoi(current + 6));
+        PerftOptions options;
+        options.threads = Threads.count();
+        if (const char* hash = strstr(current, "hash")) {
+            options.hash_mb = static_cast<std::size_t>(atoi(hash + 5));
+        }
+        perft_debug(pos, atoi(current + 6), options);
         return false;
     }
 
@@ -141,6 +150,12 @@ bool parse_go(const char* cmd, Position& pos, SearchLimits& limits) {
         max_nodes = atoll(current + 6);
     }
 
+    // CPU time summed over every search thread, in milliseconds
+    std::int64_t cpu_time = 0;
+    if ((current = strstr(cmd, "cputime"))) {
+        cpu_time = atoll(current + 8);
+    }
+
     if ((current = strstr(cmd, "movetime"))) {
         // Explicit per-move time: spend it exactly, no soft cutoff.
         movetime = atoll(current + 9);
@@ -191,7 +206,7 @@ bool parse_go(const char* cmd, Position& pos, SearchLimits& limits) {
     // "stop" (bounded only by the depth-64 / one-day ceilings), so they skip
     // the fallback.
     if (!ponder && !infinite && !depth && !movetime && !soft_time &&
-        !max_nodes) {
+        !max_nodes && !cpu_time) {
         depth = 6;
     }
 
@@ -201,6 +216,7 @@ bool parse_go(const char* cmd, Position& pos, SearchLimits& limits) {
         std::chrono::milliseconds(hard_time ? hard_time : ONE_DAY_MS);
     limits.soft_time = std::chrono::milliseconds(soft_time);  // 0 => no cutoff
     limits.node_limit = static_cast<std::uint64_t>(max_nodes);
+    limits.cpu_time = std::chrono::milliseconds(cpu_time);
     limits.depth = depth ? depth : 64;
     limits.ponder = ponder;
 
@@ -242,6 +258,19 @@ void run_search(Position& pos, SearchLimits limits) {
     }
 }
 
+// The reply to "uci": engine id, every option and "uciok". Also sent
+// unprompted at startup
+void print_uci_options() {
+    std::cout << "id name " << NAME << "\n";
+    std::cout << "id author " << AUTHOR << "\n";
+    std::cout << "option name Threads type spin default 1 min 1 max 256\n";
+    std::cout << "option name Hash type spin default 64 min 1 max 4096\n";
+    std::cout << "option name SharedHash type string default <empty>\n";
+    std::cout << "option name Ponder type check default false\n";
+    std::cout << "option name TTStats type check default false\n";
+    std::cout << "uciok\n";
+}
+
 /*
         GUI -> isready
         Engine -> readyok
@@ -257,12 +286,7 @@ void uci_loop() {
     // def user/GUI inout buffer
     char input_buffer[INPUT_BUFFER];
 
-    std::cout << "id name " << NAME << "\n";
-    std::cout << "id author " << AUTHOR << "\n";
-    std::cout << "option name Threads type spin default 1 min 1 max 256\n";
-    std::cout << "option name Hash type spin default 64 min 1 max 4096\n";
-    std::cout << "option name Ponder type check default false\n";
-    std::cout << "uciok\n";
+    print_uci_options();
 
     InfoListPtr infos(new std::deque<MoveInfo>(1));
     Position pos;
@@ -311,12 +335,53 @@ void uci_loop() {
         // parse UCI "setoption" command
         else if (strncmp(input_buffer, "setoption", 9) == 0) {
             const char* val = strstr(input_buffer, "value");
-            if (val && strstr(input_buffer, "Threads")) {
+            if (val && strstr(input_buffer, "TTStats")) {
+                // Debug counters for sizing Hash; reported after each search
+                tt::TT.set_stats(strstr(val, "true") != nullptr);
+            } else if (val && strstr(input_buffer, "Threads")) {
                 Threads.set_count(atoi(val + 6));
-            } else if (val && strstr(input_buffer, "Hash")) {
+            } else if (val && strstr(input_buffer, "name Hash ")) {
                 // Resize the transposition table to the requested MB. Wipes
                 // its contents, so this is a between-games operation.
-                tt::TT.resize(static_cast<std::size_t>(atoi(val + 6)));
+                stop_and_join();  // the workers do the zeroing
+
+                std::size_t mb = static_cast<std::size_t>(atoi(val + 6));
+                auto start = std::chrono::steady_clock::now();
+                tt::TT.resize(mb);
+                auto elapsed =
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - start);
+
+                std::lock_guard<std::mutex> io_lock(io_mutex);
+                std::cout << "info string Hash " << mb << " MB allocated in "
+                          << elapsed.count() << " ms, huge pages "
+                          << (tt::TT.huge_pages() ? "on" : "off") << "\n";
+            } else if (val && strstr(input_buffer, "SharedHash")) {
+                // Name of a shared-memory segment to search in together
+                // with other engine processes; <empty> goes back to a
+                // private table of the same size
+                stop_and_join();
+
+                std::string name = val + 6;
+                name.erase(name.find_last_not_of(" \t\r\n") + 1);
+                std::size_t mb =
+                    tt::TT.size() * sizeof(tt::Cluster) / (1024 * 1024);
+
+                std::string error;
+                std::lock_guard<std::mutex> io_lock(io_mutex);
+                if (name.empty() || name == "<empty>") {
+                    if (tt::TT.is_shared()) {
+                        tt::TT.resize(mb);
+                    }
+                } else if (tt::TT.attach_shared(name, mb, error)) {
+                    std::cout << "info string shared hash " << name << ", "
+                              << tt::TT.size() * sizeof(tt::Cluster) /
+                                     (1024 * 1024)
+                              << " MB\n";
+                } else {
+                    std::cout << "info string SharedHash failed: " << error
+                              << "\n";
+                }
             }
         }
         // parse UCI "position" command
@@ -326,6 +391,7 @@ void uci_loop() {
 
         // parse UCI "ucinewgame" command
         else if (strncmp(input_buffer, "ucinewgame", 10) == 0) {
+            stop_and_join();
             tt::TT.clear();
             Threads.clear_history();
             parse_position("position startpos", pos, infos);
@@ -351,6 +417,7 @@ void uci_loop() {
             SearchEngine::ponderhit(current_limits.soft_time.count() > 0
                                         ? current_limits.soft_time
                                         : current_limits.max_time);
+            SearchEngine::set_cpu_budget(current_limits.cpu_time);
         }
 
         // parse UCI "stop" command: halt the current search. run_search then
@@ -367,12 +434,8 @@ void uci_loop() {
 
         // parse UCI "uci" command
         else if (strncmp(input_buffer, "uci", 3) == 0) {
-            std::cout << "\nid name " << NAME << "\n";
-            std::cout << "id author " << AUTHOR << "\n";
-            std::cout << "option name Threads type spin default 1 min 1 max 256\n";
-            std::cout << "option name Hash type spin default 64 min 1 max 4096\n";
-            std::cout << "option name Ponder type check default false\n";
-            std::cout << "uciok\n";
+            std::cout << "\n";
+            print_uci_options();
         }
 
         // parse debug "eval" command - static evaluation breakdown,
@@ -395,6 +458,52 @@ void uci_loop() {
             }
         }
 
+        // parse "hashsave <file>" / "hashload <file>": persist the
+        // transposition table across restarts, e.g. for long analysis of the
+        // same lines. A loaded file replaces the table and sets its size
+        else if (strncmp(input_buffer, "hashsave", 8) == 0 ||
+                 strncmp(input_buffer, "hashload", 8) == 0) {
+            stop_and_join();
+
+            bool saving = input_buffer[4] == 's';
+            std::string path = input_buffer + 8;
+            path.erase(0, path.find_first_not_of(" \t"));
+            path.erase(path.find_last_not_of(" \t\r\n") + 1);
+
+            auto start = std::chrono::steady_clock::now();
+            std::string error;
+            bool ok = !path.empty() && (saving ? tt::TT.save(path, error)
+                                               : tt::TT.load(path, error));
+            auto elapsed =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start);
+
+            std::lock_guard<std::mutex> io_lock(io_mutex);
+            if (ok) {
+                std::cout << "info string " << (saving ? "saved " : "loaded ")
+                          << tt::TT.size() * sizeof(tt::Cluster) / (1024 * 1024)
+                          << " MB hash " << (saving ? "to " : "from ") << path
+                          << " in " << elapsed.count() << " ms\n";
+            } else {
+                std::cout << "info string " << (saving ? "hashsave" : "hashload")
+                          << " failed: "
+                          << (path.empty() ? "no file given" : error) << "\n";
+            }
+        }
+
+        // parse debug "tt" command - hashfull and the TT counters of the
+        // last search
+        else if (strncmp(input_buffer, "tt", 2) == 0) {
+            tt::TT.print_stats();
+        }
+
+        // parse "bench [depth] [threads] [hash]": fixed-depth search of the
+        // built-in positions, printing the node signature and speed
+        else if (strncmp(input_buffer, "bench", 5) == 0) {
+            stop_and_join();
+            bench_command(input_buffer + 5);
+        }
+
         else if (!strncmp(input_buffer, "d", 1)) {
             std::cout << pos << std::endl;
         }
@@ -5,15 +5,24 @@
 namespace KhaosChess {
 namespace Zobrist {
 
+#if defined(KHAOS_EMBEDDED_TABLES)
+// Drawn at build time by tools/tablegen.cpp
+#include "zobrist_tables.inc"
+#else
 BITBOARD psq[PIECE_NB][SQUARE_TOTAL];
 BITBOARD en_passant[FILE_NB];
 BITBOARD castling[CASTLING_RIGHT_NB];
 BITBOARD side;
+#endif
 
-// The seed is fixed on purpose: keys must be identical on every run so
-// stored hashes (transposition table, test expectations) stay valid
 void init() {
-    PRNG rng(1070372);
+#if !defined(KHAOS_EMBEDDED_TABLES)
+    generate();
+#endif
+}
+
+void generate() {
+    PRNG rng(SEED);
 
     for (Piece p = WHITE_PAWN; p <= BLACK_KING; ++p) {
         for (Square s = A8; s <= H1; ++s) {
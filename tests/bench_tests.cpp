@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#include "bench.h"
+#include "test_common.h"
+#include "thread.h"
+#include "tt.h"
+
+using namespace KhaosChess;
+
+namespace {
+
+class BenchTest : public ::testing::Test {
+   protected:
+    static void SetUpTestSuite() {
+        init_engine_once();
+        tt::TT.resize(8);
+    }
+};
+
+// The single-threaded node count is the signature builds are compared by,
+// so it must not depend on what was searched before
+TEST_F(BenchTest, SignatureIsDeterministic) {
+    const BenchResult first = bench(5, 1, 4);
+    const BenchResult second = bench(5, 1, 4);
+
+    EXPECT_GT(first.nodes, BENCH_FENS.size());
+    EXPECT_EQ(first.nodes, second.nodes);
+}
+
+TEST_F(BenchTest, RestoresThreadsAndHash) {
+    Threads.set_count(1);
+    tt::TT.resize(8);
+    const std::size_t clusters = tt::TT.size();
+
+    bench(3, 2, 4);
+
+    EXPECT_EQ(Threads.count(), 1);
+    EXPECT_EQ(tt::TT.size(), clusters);
+
+    // A loaded or shared table could not be put back, so bench must leave
+    // it alone rather than quietly swap in an empty private one
+    std::string error;
+    const std::string path = ::testing::TempDir() + "khaos_bench_test.hash";
+    tt::TT.store(42, 1, 1, tt::Flag::F_EXACT, Move(E2, E4));
+    ASSERT_TRUE(tt::TT.save(path, error)) << error;
+    ASSERT_TRUE(tt::TT.load(path, error)) << error;
+
+    EXPECT_FALSE(bench(3, 1, 4).error.empty());
+    EXPECT_TRUE(tt::TT.from_file());
+    bool found = false;
+    tt::TT.probe(42, found);
+    EXPECT_TRUE(found);
+    std::remove(path.c_str());
+
+#if defined(__unix__) || defined(__APPLE__)
+    const std::string name = "/khaos-bench-test-" + std::to_string(getpid());
+    ASSERT_TRUE(tt::TT.attach_shared(name, 2, error)) << error;
+
+    EXPECT_FALSE(bench(3, 1, 4).error.empty());
+    EXPECT_TRUE(tt::TT.is_shared());
+#endif
+
+    tt::TT.resize(8);
+    EXPECT_TRUE(bench(3, 1, 4).error.empty());
+}
+
+TEST_F(BenchTest, EveryPositionLoads) {
+    for (const std::string& fen : BENCH_FENS) {
+        Position pos;
+        MoveInfo mi{};
+        pos.set(fen, &mi);
+
+        EXPECT_NE(pos.square<KING>(WHITE), NONE) << fen;
+        EXPECT_NE(pos.square<KING>(BLACK), NONE) << fen;
+    }
+}
+
+}  // namespace
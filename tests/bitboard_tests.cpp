@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <vector>
+
+#include "random.h"
 #include "test_common.h"
 
 using namespace KhaosChess;
@@ -105,4 +109,127 @@ TEST_F(BitboardTest, LinesAndAlignment) {
     EXPECT_FALSE(in_between_bb(A1, A8) & A1);
 }
 
+// Backends the running build and CPU can switch to
+std::vector<SliderBackend> available_backends() {
+    std::vector<SliderBackend> out;
+    for (SliderBackend b : {SliderBackend::MAGIC, SliderBackend::PEXT}) {
+        SliderBackend before = Bitboards::slider_backend();
+        if (Bitboards::set_slider_backend(b)) {
+            out.push_back(b);
+        }
+        Bitboards::set_slider_backend(before);
+    }
+    return out;
+}
+
+// Every backend must reproduce the ray-walking reference on sparse and
+// dense random occupancies
+TEST_F(BitboardTest, SliderBackendsMatchRayWalk) {
+    const SliderBackend original = Bitboards::slider_backend();
+
+    for (SliderBackend backend : available_backends()) {
+        ASSERT_TRUE(Bitboards::set_slider_backend(backend));
+        PRNG rng(1070372);
+
+        for (Square s = A8; s <= H1; ++s) {
+            for (int i = 0; i < 1000; ++i) {
+                BITBOARD occ = rng.rand<BITBOARD>();
+                occ &= (i & 1) ? rng.rand<BITBOARD>() : ~0ULL;
+
+                ASSERT_EQ(attacks_bb_by<ROOK>(s, occ),
+                          sliding_attacks(ROOK, s, occ))
+                    << Bitboards::slider_backend_name();
+                ASSERT_EQ(attacks_bb_by<BISHOP>(s, occ),
+                          sliding_attacks(BISHOP, s, occ))
+                    << Bitboards::slider_backend_name();
+            }
+        }
+    }
+
+    Bitboards::set_slider_backend(original);
+}
+
+// Exhaustive check of the packed table: every subset of every square's
+// relevant blockers, under every backend
+TEST_F(BitboardTest, PackedSliderTableCoversEverySubset) {
+    const SliderBackend original = Bitboards::slider_backend();
+
+    // One table whichever backend is active, not one per backend
+    EXPECT_LT(sizeof(mSliderAttacks), 900u * 1024);
+
+    for (SliderBackend backend : available_backends()) {
+        ASSERT_TRUE(Bitboards::set_slider_backend(backend));
+
+        // Rook and bishop slots fill the packed table exactly
+        EXPECT_EQ(rook_magic_tbl[A8].attack, mSliderAttacks);
+        EXPECT_EQ(bishop_magic_tbl[H1].attack + (1 << RELEVANT_BISHOP_BITS[H1]),
+                  mSliderAttacks + SLIDER_ATTACKS_SIZE);
+
+        for (Square s = A8; s <= H1; ++s) {
+            for (PieceType pt : {ROOK, BISHOP}) {
+                const SMagic& sm =
+                    (pt == ROOK) ? rook_magic_tbl[s] : bishop_magic_tbl[s];
+
+                // Carry-Rippler walk over all subsets of the mask
+                BITBOARD subset = 0;
+                do {
+                    ASSERT_EQ(attacks_bb_by(pt, s, subset),
+                              sliding_attacks(pt, s, subset))
+                        << Bitboards::slider_backend_name() << " square "
+                        << s;
+                    subset = (subset - sm.mask) & sm.mask;
+                } while (subset);
+            }
+        }
+    }
+
+    Bitboards::set_slider_backend(original);
+}
+
+// Slider lookups per second for each available backend. No speed
+// assertion, like the perft benchmarks; the numbers are printed and
+// recorded for comparison.
+TEST_F(BitboardTest, SliderLookupBenchmark) {
+    const SliderBackend original = Bitboards::slider_backend();
+    std::cout << "[ SLIDERS  ] selected at startup: "
+              << Bitboards::slider_backend_name() << "\n";
+
+    // Occupancies drawn up front so the loop measures lookups only
+    constexpr int kOccupancies = 4096;
+    std::vector<BITBOARD> occupancies(kOccupancies);
+    PRNG rng(2024);
+    for (BITBOARD& occ : occupancies) {
+        occ = rng.rand<BITBOARD>() & rng.rand<BITBOARD>();
+    }
+
+    for (SliderBackend backend : available_backends()) {
+        ASSERT_TRUE(Bitboards::set_slider_backend(backend));
+
+        constexpr int kRounds = 50;
+        BITBOARD sink = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < kRounds; ++round) {
+            for (Square s = A8; s <= H1; ++s) {
+                for (BITBOARD occ : occupancies) {
+                    sink ^= attacks_bb_by<ROOK>(s, occ) ^
+                            attacks_bb_by<BISHOP>(s, occ ^ sink);
+                }
+            }
+        }
+        const double seconds = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+
+        const double lookups = 2.0 * kRounds * SQUARE_TOTAL * kOccupancies;
+        const double mlps = lookups / seconds / 1e6;
+        std::cout << "[ SLIDERS  ] " << Bitboards::slider_backend_name()
+                  << ": " << mlps << " M lookups/s (checksum " << (sink & 0xFF)
+                  << ")\n";
+        RecordProperty(Bitboards::slider_backend_name(),
+                       static_cast<int>(mlps));
+    }
+
+    Bitboards::set_slider_backend(original);
+}
+
 }  // namespace
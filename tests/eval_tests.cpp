@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "endgame.h"
+#include "score.h"
+#include "test_common.h"
+
+using namespace KhaosChess;
+
+namespace {
+
+class EvalTest : public ::testing::Test {
+   protected:
+    static void SetUpTestSuite() { init_engine_once(); }
+
+    // Calls visit(pos) on every node of the tree below pos
+    template <typename Visit>
+    static void walk(Position& pos, std::int32_t depth, Visit&& visit) {
+        visit(pos);
+        if (depth == 0) {
+            return;
+        }
+
+        for (const auto& m : MoveList<GT_LEGAL>(pos)) {
+            MoveInfo move_info;
+            pos.do_move(m, move_info);
+            walk(pos, depth - 1, visit);
+            pos.undo_move(m);
+        }
+    }
+
+    static const std::vector<std::string>& fens() {
+        static const std::vector<std::string> list = {
+            kStartPos, kKiwipete, kEnPassantPins, kPromotions, kTalkchess};
+        return list;
+    }
+};
+
+// Taking the pawn terms from the table must not change any eval, on a hit
+// or on a miss; one table across all trees also exercises replacement
+TEST_F(EvalTest, PawnTableMatchesDirectEval) {
+    PawnTable table;
+    std::uint64_t nodes = 0, mismatches = 0;
+
+    for (const std::string& fen : fens()) {
+        Position pos;
+        MoveInfo mi{};
+        pos.set(fen, &mi);
+
+        walk(pos, 3, [&](const Position& p) {
+            Value direct = Scorer<SC_ALL>().get_score(p);
+            Value cached = Scorer<SC_ALL>(&table).get_score(p);
+            EXPECT_EQ(cached, direct) << p.get_fen();
+            mismatches += cached != direct;
+            ++nodes;
+        });
+    }
+
+    EXPECT_EQ(mismatches, 0u);
+    EXPECT_GT(table.hits, 0u);
+    EXPECT_LE(table.probes, nodes);
+}
+
+// The cached endgame evaluator, phase and imbalance must give the evals
+// the scan and the piece counts give, in middlegames and in endgames where
+// a capture or promotion moves the position into or out of an evaluator
+TEST_F(EvalTest, MaterialTableMatchesDirectEval) {
+    MaterialTable table;
+    std::vector<std::string> list = fens();
+    list.insert(list.end(), {"8/8/8/4k3/8/8/4P3/4K3 w - - 0 1",
+                             "8/8/3k4/8/2b5/8/4R3/4K3 w - - 0 1",
+                             "8/6P1/5k2/8/8/1B6/4K3/8 w - - 0 1",
+                             "3k4/8/8/3q4/8/8/5P2/3RK3 w - - 0 1"});
+
+    for (const std::string& fen : list) {
+        Position pos;
+        MoveInfo mi{};
+        pos.set(fen, &mi);
+
+        walk(pos, 3, [&](const Position& p) {
+            const MaterialEntry& e = table.probe(p);
+            ASSERT_EQ(e.key, p.material_key());
+            ASSERT_EQ(e.endgame, Endgames::find(p)) << p.get_fen();
+
+            Value direct = Scorer<SC_ALL>().get_score(p);
+            Value cached = Scorer<SC_ALL>(nullptr, &table).get_score(p);
+            ASSERT_EQ(cached, direct) << p.get_fen();
+        });
+    }
+}
+
+// The running material + PSQT and phase sums must equal what the board
+// adds up to after any sequence of moves, captures, promotions and castles
+TEST_F(EvalTest, PsqAccumulatorsMatchRecompute) {
+    for (const std::string& fen : fens()) {
+        Position pos;
+        MoveInfo mi{};
+        pos.set(fen, &mi);
+
+        walk(pos, 3, [&](const Position& p) {
+            Score psq = 0;
+            std::int32_t phase = 0;
+            for (Square s = A8; s <= H1; ++s) {
+                Piece pc = p.get_piece_on(s);
+                if (pc != NO_PIECE) {
+                    psq += PSQ::table[pc][s];
+                    phase += PIECE_WEIGHTS[type_of_piece(pc)];
+                }
+            }
+
+            ASSERT_EQ(p.psq_score(), psq) << p.get_fen();
+            ASSERT_EQ(p.game_phase(), std::min(phase, MAX_PHASE_SCORE))
+                << p.get_fen();
+        });
+    }
+}
+
+// The tuner changes PSQT under live positions: with INCREMENTAL_PSQ off the
+// eval must follow the new weights at once, and PSQ::init() must bring the
+// table, and the positions set after it, up to date
+TEST_F(EvalTest, PsqtChangesAtRuntime) {
+    // Both sides read the same PSQT entry on mirrored squares, so only the
+    // white knight on f3 sees a change to its square
+    const std::string fen =
+        "r1bqkbnr/pppppppp/2n5/8/8/5N2/PPPPPPPP/RNBQKB1R w KQkq - 2 2";
+    Position pos;
+    MoveInfo mi{};
+    pos.set(fen, &mi);
+
+    const Value before = Scorer<SC_ALL>().get_score(pos);
+    const Score saved = PSQT[KNIGHT][F3];
+
+    INCREMENTAL_PSQ = false;
+    PSQT[KNIGHT][F3] += Score(8, 0);
+    const Value changed = Scorer<SC_ALL>().get_score(pos);
+
+    PSQ::init();
+    INCREMENTAL_PSQ = true;
+    Position fresh;
+    MoveInfo fresh_mi{};
+    fresh.set(fen, &fresh_mi);
+    const Value incremental = Scorer<SC_ALL>().get_score(fresh);
+
+    PSQT[KNIGHT][F3] = saved;
+    PSQ::init();
+
+    // All pieces are on, so the eval is pure middlegame and all 8 count
+    EXPECT_EQ(changed, before + 8);
+    EXPECT_EQ(incremental, changed);
+    EXPECT_EQ(Scorer<SC_ALL>().get_score(pos), before);
+}
+
+TEST_F(EvalTest, PawnEntryBitboards) {
+    PawnTable table;
+
+    // a2 and h7 are passed; e4 and e5 block each other
+    Position pos;
+    MoveInfo mi{};
+    pos.set("4k3/7p/8/4p3/4P3/8/P7/4K3 w - - 0 1", &mi);
+
+    const PawnEntry& e = table.probe(pos);
+    EXPECT_EQ(e.key, pos.pawn_key());
+    EXPECT_EQ(e.attacks[WHITE], pos.get_attacks_by<PAWN>(WHITE));
+    EXPECT_EQ(e.attacks[BLACK], pos.get_attacks_by<PAWN>(BLACK));
+    EXPECT_EQ(e.passed[WHITE], square_to_BB(A2));
+    EXPECT_EQ(e.passed[BLACK], square_to_BB(H7));
+}
+
+}  // namespace
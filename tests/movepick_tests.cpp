@@ -0,0 +1,274 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "movepick.h"
+#include "test_common.h"
+
+using namespace KhaosChess;
+
+namespace {
+
+// The staged picker must hand out exactly the legal moves, each once, in
+// tier order, whatever TT move and killers it is fed
+class MovePickerTest : public ::testing::Test {
+   protected:
+    static void SetUpTestSuite() { init_engine_once(); }
+
+    // Every FEN in `fens` and all positions one and two plies below them.
+    // The second ply brings in plenty of check and en passant positions.
+    static std::vector<std::string> walk(const std::vector<std::string>& fens) {
+        std::vector<std::string> out;
+
+        for (const std::string& fen : fens) {
+            Position pos;
+            MoveInfo mi{};
+            pos.set(fen, &mi);
+            out.push_back(fen);
+
+            for (const ScoredMoves& m1 : MoveList<GT_LEGAL>(pos)) {
+                MoveInfo mi1;
+                pos.do_move(m1, mi1);
+                out.push_back(pos.get_fen());
+
+                for (const ScoredMoves& m2 : MoveList<GT_LEGAL>(pos)) {
+                    MoveInfo mi2;
+                    pos.do_move(m2, mi2);
+                    out.push_back(pos.get_fen());
+                    pos.undo_move(m2);
+                }
+                pos.undo_move(m1);
+            }
+        }
+
+        return out;
+    }
+
+    static std::vector<std::string> positions() {
+        static const std::vector<std::string> all =
+            walk({kStartPos, kKiwipete, kEnPassantPins, kPromotions,
+                  kTalkchess});
+        return all;
+    }
+
+    // Moves seen anywhere in the walk: realistic stale killers/TT moves
+    static std::vector<Move> candidates() {
+        std::set<std::uint16_t> seen;
+        for (const std::string& fen : positions()) {
+            Position pos;
+            MoveInfo mi{};
+            pos.set(fen, &mi);
+            for (const ScoredMoves& m : MoveList<GT_LEGAL>(pos)) {
+                seen.insert(m.move_value());
+            }
+        }
+
+        std::vector<Move> out;
+        for (std::uint16_t v : seen) {
+            out.push_back(Move(v));
+        }
+        return out;
+    }
+
+    static bool in_check(const Position& pos) {
+        Color us = pos.side_to_move();
+        return pos.get_attackers_to(pos.square<KING>(us)) &
+               pos.get_opponent_pieces_bb();
+    }
+
+    static bool is_capture(const Position& pos, Move m) {
+        return ((m.move_type() != MT_CASTLING) &&
+                !pos.is_empty(m.target_square())) ||
+               (m.move_type() == MT_EN_PASSANT);
+    }
+
+    static std::vector<std::uint16_t> drain(MovePicker& picker) {
+        std::vector<std::uint16_t> out;
+        for (Move m = picker.next_move(); m != Move::invalid_move();
+             m = picker.next_move()) {
+            out.push_back(m.move_value());
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    static std::vector<std::uint16_t> legal(const Position& pos,
+                                            bool captures_only) {
+        std::vector<std::uint16_t> out;
+        for (const ScoredMoves& m : MoveList<GT_LEGAL>(pos)) {
+            if (!captures_only || is_capture(pos, m) ||
+                (m.move_type() == MT_PROMOTION)) {
+                out.push_back(m.move_value());
+            }
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+};
+
+TEST_F(MovePickerTest, PseudoLegalAgreesWithGeneratorOnEveryEncoding) {
+    for (const std::string& fen : {kStartPos, kKiwipete, kEnPassantPins,
+                                   kPromotions, kTalkchess}) {
+        Position pos;
+        MoveInfo mi{};
+        pos.set(fen, &mi);
+
+        std::vector<std::uint16_t> expected = legal(pos, false);
+        for (std::uint32_t v = 0; v < 65536; ++v) {
+            Move m(static_cast<std::uint16_t>(v));
+            bool generated =
+                std::binary_search(expected.begin(), expected.end(), v);
+
+            // A pseudo-legal move only counts once is_legal() agrees
+            bool accepted = pos.is_pseudo_legal(m) && pos.is_legal(m);
+            ASSERT_EQ(accepted, generated) << fen << " move " << m;
+        }
+    }
+}
+
+// Castling, en passant and promotions are checked without the generator,
+// so each gets the cases it could get wrong
+TEST_F(MovePickerTest, PseudoLegalAgreesWithGeneratorOnSpecialMoves) {
+    for (const char* fen : {
+             // en passant takes the checking pawn
+             "8/8/8/3pP3/4K3/8/8/7k w - d6 0 1",
+             // en passant neither takes nor blocks the discovered check
+             "1b5k/8/8/2pP4/5K2/8/8/8 w - c6 0 1",
+             // ... nor the knight check, which is_legal() does not look at
+             "7k/8/8/2pP4/8/4n3/8/3K4 w - c6 0 1",
+             // kingside crosses an attacked square, queenside is blocked
+             "r3k2r/8/8/8/8/8/5r2/RN2K2R w KQkq - 0 1",
+             // castling out of check
+             "r3k2r/8/8/8/8/8/4r3/R3K2R w KQkq - 0 1",
+             // promoting blocks or takes the checker, or leaves it
+             "r6K/1P6/8/8/8/8/6P1/k7 w - - 0 1",
+         }) {
+        Position pos;
+        MoveInfo mi{};
+        pos.set(fen, &mi);
+
+        std::vector<std::uint16_t> expected = legal(pos, false);
+        for (std::uint32_t v = 0; v < 65536; ++v) {
+            Move m(static_cast<std::uint16_t>(v));
+            bool generated =
+                std::binary_search(expected.begin(), expected.end(), v);
+
+            bool accepted = pos.is_pseudo_legal(m) && pos.is_legal(m);
+            ASSERT_EQ(accepted, generated) << fen << " move " << m;
+        }
+    }
+}
+
+TEST_F(MovePickerTest, PseudoLegalAgreesWithGeneratorOnStaleMoves) {
+    const std::vector<Move> moves = candidates();
+
+    for (const std::string& fen : positions()) {
+        Position pos;
+        MoveInfo mi{};
+        pos.set(fen, &mi);
+
+        MoveList<GT_LEGAL> list(pos);
+        MoveList<GT_ALL> pseudo(pos);
+        for (Move m : moves) {
+            bool accepted = pos.is_pseudo_legal(m) && pos.is_legal(m);
+            ASSERT_EQ(accepted, list.contains_move(m)) << fen << " move " << m;
+
+            // Never wider than the generator, pins aside
+            if (!in_check(pos) && pos.is_pseudo_legal(m)) {
+                ASSERT_TRUE(pseudo.contains_move(m)) << fen << " move " << m;
+            }
+        }
+    }
+}
+
+TEST_F(MovePickerTest, YieldsEveryLegalMoveOnce) {
+    const std::vector<Move> moves = candidates();
+    HistoryTable history{};
+    ContinuationTable continuation{};
+
+    std::size_t i = 0;
+    for (const std::string& fen : positions()) {
+        Position pos;
+        MoveInfo mi{};
+        pos.set(fen, &mi);
+
+        // Stale TT move, killers and countermove, some of them legal here
+        Move killers[2] = {moves[i % moves.size()],
+                           moves[(i * 7 + 3) % moves.size()]};
+        Move tt_move = moves[(i * 13 + 5) % moves.size()];
+        Move counter = moves[(i * 31 + 11) % moves.size()];
+        ++i;
+
+        MovePicker main(pos, tt_move, killers, counter, history,
+                        &continuation);
+        ASSERT_EQ(drain(main), legal(pos, false)) << fen;
+
+        // Quiescence: captures and promotions only, unless in check
+        MovePicker qsearch(pos, tt_move);
+        ASSERT_EQ(drain(qsearch), legal(pos, !in_check(pos))) << fen;
+    }
+}
+
+TEST_F(MovePickerTest, StagesComeOutInOrder) {
+    HistoryTable history{};
+    for (std::int32_t from = 0; from < SQUARE_TOTAL; ++from) {
+        for (std::int32_t to = 0; to < SQUARE_TOTAL; ++to) {
+            history[from][to] = (from * 37 + to * 101) % 1000;
+        }
+    }
+
+    for (const std::string& fen : positions()) {
+        Position pos;
+        MoveInfo mi{};
+        pos.set(fen, &mi);
+        if (in_check(pos)) {
+            continue;
+        }
+
+        // Make the last quiet a killer and the first capture the TT move
+        MoveList<GT_LEGAL> list(pos);
+        Move tt_move = Move::invalid_move();
+        Move killers[2] = {Move::invalid_move(), Move::invalid_move()};
+        for (const ScoredMoves& m : list) {
+            if (is_capture(pos, m) && (tt_move == Move::invalid_move())) {
+                tt_move = m;
+            }
+            if (!is_capture(pos, m) && (m.move_type() != MT_PROMOTION)) {
+                killers[0] = m;
+            }
+        }
+
+        MovePicker picker(pos, tt_move, killers, Move::invalid_move(),
+                          history, nullptr);
+
+        // 0 TT move, 1 winning capture, 2 killer, 3 quiet, 4 losing capture
+        std::int32_t tier = 0;
+        std::int32_t last_quiet = HISTORY_MAX;
+        bool first = true;
+        for (Move m = picker.next_move(); m != Move::invalid_move();
+             m = picker.next_move(), first = false) {
+            std::int32_t t;
+            if (m == tt_move) {
+                ASSERT_TRUE(first) << fen;
+                t = 0;
+            } else if (is_capture(pos, m) || (m.move_type() == MT_PROMOTION)) {
+                t = pos.see_ge(m, 0) ? 1 : 4;
+            } else if (m == killers[0]) {
+                t = 2;
+            } else {
+                t = 3;
+                std::int32_t score =
+                    history[m.source_square()][m.target_square()];
+                ASSERT_LE(score, last_quiet) << fen;
+                last_quiet = score;
+            }
+
+            ASSERT_GE(t, tier) << fen << " move " << m;
+            tier = t;
+        }
+    }
+}
+
+}  // namespace
@@ -1,7 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <vector>
 
 #include "perft.h"
 #include "test_common.h"
@@ -67,4 +69,153 @@ TEST_F(PerftBenchmark, KiwipeteDepth5) {
     benchmark(kKiwipete, 5, 193690690u);
 }
 
+// The fast perft in every combination of its switches must count exactly
+// what the reference walk counts
+class FastPerftTest : public ::testing::Test {
+   protected:
+    static void SetUpTestSuite() { init_engine_once(); }
+
+    static void check(const std::string& fen, std::int32_t depth) {
+        Position pos;
+        MoveInfo mi{};
+        pos.set(fen, &mi);
+
+        const BITBOARD key = pos.key();
+        const std::uint64_t expected = perft_driver(pos, depth);
+        for (bool bulk : {false, true}) {
+            for (std::size_t hash_mb : {std::size_t{0}, std::size_t{1}}) {
+                for (std::int32_t threads : {1, 4}) {
+                    EXPECT_EQ(perft(pos, depth, {bulk, hash_mb, threads}),
+                              expected)
+                        << "FEN: " << fen << " bulk " << bulk << " hash "
+                        << hash_mb << " threads " << threads;
+                }
+            }
+        }
+
+        // The board is left as it was found
+        EXPECT_EQ(pos.key(), key);
+    }
+};
+
+TEST_F(FastPerftTest, MatchesReferenceInEveryMode) {
+    check(kStartPos, 4);
+    check(kKiwipete, 3);
+    check(kEnPassantPins, 5);
+    check(kPromotions, 3);
+    check(kTalkchess, 3);
+}
+
+// The fast perft on the KiwipeteDepth5 tree, each mode added in turn; the
+// reference walk's speed is that benchmark's line. Printed only.
+TEST_F(FastPerftTest, SpeedBenchmark) {
+    Position pos;
+    MoveInfo mi{};
+    pos.set(kKiwipete, &mi);
+
+    const auto run = [&](const char* name, auto&& count) {
+        const auto start = std::chrono::steady_clock::now();
+        const std::uint64_t nodes = count();
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+
+        EXPECT_EQ(nodes, 193690690u) << name;
+        const double seconds = elapsed.count() / 1000.0;
+        const double mnps = seconds > 0 ? nodes / seconds / 1e6 : 0.0;
+        std::cout << "[ PERFT    ] kiwipete depth 5, " << name << ": "
+                  << elapsed.count() << " ms  (" << mnps << " Mnps)\n";
+    };
+
+    run("bulk", [&] { return perft(pos, 5, {true, 0, 1}); });
+    run("bulk+hash 16MB", [&] { return perft(pos, 5, {true, 16, 1}); });
+    run("bulk+hash 16MB, 4 threads",
+        [&] { return perft(pos, 5, {true, 16, 4}); });
+}
+
+// The direct legal generators must agree, at every node of the tree, with
+// the reference method: pseudo-legal moves (evasions when in check) with
+// the illegal ones filtered out by Position::is_legal
+class LegalGenerationTest : public ::testing::Test {
+   protected:
+    static void SetUpTestSuite() { init_engine_once(); }
+
+    static bool is_capture(const Position& pos, Move m) {
+        return ((m.move_type() != MT_CASTLING) &&
+                !pos.is_empty(m.target_square())) ||
+               (m.move_type() == MT_EN_PASSANT);
+    }
+
+    template <GenerationTypes T>
+    static std::vector<std::uint16_t> sorted(const Position& pos) {
+        std::vector<std::uint16_t> out;
+        for (const auto& m : MoveList<T>(pos)) {
+            out.push_back(m.move_value());
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    static std::vector<std::uint16_t> reference(const Position& pos,
+                                                bool captures_only) {
+        Color us = pos.side_to_move();
+        Square ksq = pos.square<KING>(us);
+        bool in_check =
+            pos.get_attackers_to(ksq) & pos.get_opponent_pieces_bb();
+
+        ScoredMoves moves[MAX_MOVES];
+        ScoredMoves* end = in_check ? generate_moves<GT_EVADE>(pos, moves)
+                                    : generate_moves<GT_ALL>(pos, moves);
+
+        std::vector<std::uint16_t> out;
+        for (ScoredMoves* m = moves; m != end; ++m) {
+            bool tactical =
+                is_capture(pos, *m) || (m->move_type() == MT_PROMOTION);
+            if ((!captures_only || tactical) && pos.is_legal(*m)) {
+                out.push_back(m->move_value());
+            }
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    // Perft-style walk; returns the number of nodes compared
+    static std::uint64_t compare_tree(Position& pos, std::int32_t depth) {
+        EXPECT_EQ(sorted<GT_LEGAL>(pos), reference(pos, false))
+            << "FEN: " << pos.get_fen();
+        EXPECT_EQ(sorted<GT_LEGAL_CAPTURE>(pos), reference(pos, true))
+            << "FEN: " << pos.get_fen();
+
+        std::uint64_t compared = 1;
+        if (depth == 0) {
+            return compared;
+        }
+
+        for (const auto& m : MoveList<GT_LEGAL>(pos)) {
+            MoveInfo move_info;
+            pos.do_move(m, move_info);
+            compared += compare_tree(pos, depth - 1);
+            pos.undo_move(m);
+        }
+
+        return compared;
+    }
+
+    static void check(const std::string& fen, std::int32_t depth) {
+        Position pos;
+        MoveInfo mi{};
+        pos.set(fen, &mi);
+
+        EXPECT_GT(compare_tree(pos, depth), 0u) << "FEN: " << fen;
+    }
+};
+
+TEST_F(LegalGenerationTest, MatchesFilteredPseudoLegalMoves) {
+    check(kStartPos, 4);
+    check(kKiwipete, 3);
+    check(kEnPassantPins, 4);
+    check(kPromotions, 3);
+    check(kTalkchess, 3);
+}
+
 }  // namespace
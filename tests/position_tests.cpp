@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
 #include "perft.h"
 #include "test_common.h"
 
@@ -36,6 +41,235 @@ TEST_P(PositionTest, NodeCount) {
     EXPECT_EQ(perft_driver(pos, c.depth), c.expected) << "FEN: " << c.fen;
 }
 
+// Walks the tree and checks that the key predicted before every move is the
+// key do_move actually produces; returns the number of mismatches
+std::uint64_t key_after_mismatches(Position& pos, std::int32_t depth) {
+    if (depth == 0) {
+        return 0;
+    }
+
+    std::uint64_t mismatches = 0;
+    for (const auto& m : MoveList<GT_LEGAL>(pos)) {
+        BITBOARD predicted = pos.key_after(m);
+
+        MoveInfo move_info;
+        pos.do_move(m, move_info);
+
+        EXPECT_EQ(predicted, pos.key()) << "move " << m.uci_move();
+        mismatches += (predicted != pos.key());
+        mismatches += key_after_mismatches(pos, depth - 1);
+
+        pos.undo_move(m);
+    }
+
+    return mismatches;
+}
+
+TEST_P(PositionTest, KeyAfterMatchesDoMove) {
+    const PerftCase& c = GetParam();
+
+    Position pos;
+    MoveInfo mi{};
+    pos.set(c.fen, &mi);
+
+    EXPECT_EQ(key_after_mismatches(pos, std::min(c.depth, 3)), 0u)
+        << "FEN: " << c.fen;
+}
+
+// Walks the tree and compares the pawn key do_move kept against the one a
+// position set up from scratch gets; returns the number of mismatches
+std::uint64_t pawn_key_mismatches(Position& pos, std::int32_t depth) {
+    Position fresh;
+    MoveInfo fresh_mi{};
+    fresh.set(pos.get_fen(), &fresh_mi);
+
+    EXPECT_EQ(pos.pawn_key(), fresh.pawn_key()) << pos.get_fen();
+    std::uint64_t mismatches = pos.pawn_key() != fresh.pawn_key();
+    if (depth == 0) {
+        return mismatches;
+    }
+
+    for (const auto& m : MoveList<GT_LEGAL>(pos)) {
+        MoveInfo move_info;
+        pos.do_move(m, move_info);
+        mismatches += pawn_key_mismatches(pos, depth - 1);
+        pos.undo_move(m);
+    }
+
+    return mismatches;
+}
+
+TEST_P(PositionTest, PawnKeyMatchesFullRecompute) {
+    const PerftCase& c = GetParam();
+
+    Position pos;
+    MoveInfo mi{};
+    pos.set(c.fen, &mi);
+
+    EXPECT_EQ(pawn_key_mismatches(pos, std::min(c.depth, 3)), 0u)
+        << "FEN: " << c.fen;
+}
+
+// Walks the tree, null moves included, and compares the king lines do_move
+// kept or redid against a position set up from scratch; returns the number
+// of mismatching nodes
+std::uint64_t king_line_mismatches(Position& pos, std::int32_t depth) {
+    Position fresh;
+    MoveInfo fresh_mi{};
+    fresh.set(pos.get_fen(), &fresh_mi);
+
+    bool same = true;
+    for (Color c : {WHITE, BLACK}) {
+        same &= pos.get_king_blockers(c) == fresh.get_king_blockers(c);
+        same &= pos.get_pinners(c) == fresh.get_pinners(c);
+    }
+    for (PieceType pt : {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING}) {
+        same &= pos.get_threats(pt) == fresh.get_threats(pt);
+    }
+    EXPECT_TRUE(same) << pos.get_fen();
+
+    std::uint64_t mismatches = !same;
+    if (depth == 0) {
+        return mismatches;
+    }
+
+    for (const auto& m : MoveList<GT_LEGAL>(pos)) {
+        MoveInfo move_info;
+        pos.do_move(m, move_info);
+        mismatches += king_line_mismatches(pos, depth - 1);
+        pos.undo_move(m);
+    }
+
+    // Null moves copy the lines as they are; never made in check
+    Square ksq = pos.square<KING>(pos.side_to_move());
+    if (!(pos.get_attackers_to(ksq) & pos.get_opponent_pieces_bb())) {
+        MoveInfo null_info;
+        pos.do_null_move(null_info);
+        mismatches += king_line_mismatches(pos, depth - 1);
+        pos.undo_null_move();
+    }
+
+    return mismatches;
+}
+
+TEST_P(PositionTest, KingLinesMatchFullRecompute) {
+    const PerftCase& c = GetParam();
+
+    Position pos;
+    MoveInfo mi{};
+    pos.set(c.fen, &mi);
+
+    EXPECT_EQ(king_line_mismatches(pos, std::min(c.depth, 3)), 0u)
+        << "FEN: " << c.fen;
+}
+
+// A FEN with an en passant square must give the same position as playing
+// the double push that created it
+TEST(PositionFenTest, EnPassantSquareRoundTrips) {
+    init_engine_once();
+
+    Position played;
+    MoveInfo mi{};
+    played.set(kStartPos, &mi);
+
+    MoveInfo infos[4];
+    const Move moves[] = {Move(E2, E4), Move(D7, D5), Move(E4, E5),
+                          Move(F7, F5)};
+    for (std::int32_t i = 0; i < 4; ++i) {
+        played.do_move(moves[i], infos[i]);
+    }
+
+    Position parsed;
+    MoveInfo parsed_mi{};
+    parsed.set(played.get_fen(), &parsed_mi);
+
+    EXPECT_EQ(played.ep_square(), F6);
+    EXPECT_EQ(parsed.ep_square(), F6);
+    EXPECT_EQ(parsed.key(), played.key());
+    EXPECT_EQ(perft_driver(parsed, 3), perft_driver(played, 3));
+}
+
+// The UCI loop boots into the empty board before any "position" arrives
+TEST(PositionFenTest, KinglessBoardHasNoThreats) {
+    init_engine_once();
+
+    Position pos;
+    MoveInfo mi{};
+    pos.set(EMPTY_FEN, &mi);
+
+    for (PieceType pt : {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING}) {
+        EXPECT_EQ(pos.get_threats(pt), 0ULL);
+    }
+    EXPECT_EQ(pos.get_king_blockers(WHITE), 0ULL);
+    EXPECT_EQ(pos.get_king_blockers(BLACK), 0ULL);
+}
+
+// Do/undo pairs per second over every legal move of the positions two
+// plies below the test FENs. No speed assertion, like the perft
+// benchmarks; the number is printed and recorded for comparison.
+TEST(PositionBenchmark, DoUndo) {
+    init_engine_once();
+
+    struct Node {
+        Position pos;
+        MoveInfo mi{};
+        std::vector<Move> moves;
+    };
+    std::vector<std::unique_ptr<Node>> nodes;
+
+    for (const std::string& fen : {kStartPos, kKiwipete, kEnPassantPins,
+                                   kPromotions, kTalkchess}) {
+        Position root;
+        MoveInfo root_mi{};
+        root.set(fen, &root_mi);
+
+        for (const ScoredMoves& m1 : MoveList<GT_LEGAL>(root)) {
+            MoveInfo mi1;
+            root.do_move(m1, mi1);
+            for (const ScoredMoves& m2 : MoveList<GT_LEGAL>(root)) {
+                MoveInfo mi2;
+                root.do_move(m2, mi2);
+
+                auto node = std::make_unique<Node>();
+                node->pos.set(root.get_fen(), &node->mi);
+                for (const ScoredMoves& m : MoveList<GT_LEGAL>(node->pos)) {
+                    node->moves.push_back(m);
+                }
+                nodes.push_back(std::move(node));
+
+                root.undo_move(m2);
+            }
+            root.undo_move(m1);
+        }
+    }
+
+    constexpr int RUNS = 20;
+    std::uint64_t pairs = 0;
+    BITBOARD keys = 0;  // used below, so the loop is not optimized away
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < RUNS; ++run) {
+        for (auto& node : nodes) {
+            for (Move m : node->moves) {
+                MoveInfo mi;
+                node->pos.do_move(m, mi);
+                keys += node->pos.key();
+                node->pos.undo_move(m);
+            }
+            pairs += node->moves.size();
+        }
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    const double mpps = pairs / elapsed.count() / 1e6;
+    std::cout << "[ DO/UNDO  ] " << pairs << " pairs over " << nodes.size()
+              << " positions in " << elapsed.count() * 1000 << " ms  ("
+              << mpps << " M/s)\n";
+    EXPECT_NE(keys, 0u);
+    RecordProperty("mpps", static_cast<int>(mpps * 1000));
+}
+
 INSTANTIATE_TEST_SUITE_P(
     Positions, PositionTest,
     ::testing::Values(
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "test_common.h"
+#include "thread.h"
+#include "tt.h"
+#include "uci.h"
+
+using namespace KhaosChess;
+
+namespace {
+
+class SearchLimitsTest : public ::testing::Test {
+   protected:
+    static void SetUpTestSuite() {
+        init_engine_once();
+        tt::TT.resize(8);
+    }
+
+    void SetUp() override {
+        pos.set(kKiwipete, &mi);
+    }
+
+    MoveInfo mi{};
+    Position pos;
+};
+
+TEST_F(SearchLimitsTest, ParseGoReadsCputime) {
+    SearchLimits limits;
+    ASSERT_TRUE(parse_go("go cputime 250", pos, limits));
+
+    EXPECT_EQ(limits.cpu_time, std::chrono::milliseconds(250));
+    // A CPU budget is a limit of its own: no fixed-depth fallback
+    EXPECT_EQ(limits.depth, 64);
+    EXPECT_EQ(limits.node_limit, 0u);
+}
+
+TEST_F(SearchLimitsTest, ParseGoWithoutCputimeHasNoCpuBudget) {
+    SearchLimits limits;
+    ASSERT_TRUE(parse_go("go movetime 100", pos, limits));
+
+    EXPECT_EQ(limits.cpu_time, std::chrono::milliseconds(0));
+    EXPECT_EQ(limits.max_time, std::chrono::milliseconds(100));
+}
+
+// With no other bound the CPU budget alone must end the search, and the
+// workers' summed CPU time must land on it rather than run far past
+TEST_F(SearchLimitsTest, CpuTimeStopsTheSearch) {
+    for (std::int32_t threads : {1, 2}) {
+        Threads.set_count(threads);
+        tt::TT.clear();
+
+        SearchLimits limits;
+        limits.max_time = std::chrono::hours(24);
+        limits.cpu_time = std::chrono::milliseconds(200);
+
+        SearchEngine::clear_stop();
+        const SearchInfo info = Threads.run(pos, limits);
+        const SearchInfo& totals = Threads.totals();
+
+        EXPECT_FALSE(info.pv.empty()) << threads << " threads";
+        EXPECT_GE(totals.cpu_time, std::chrono::milliseconds(200))
+            << threads << " threads";
+        EXPECT_LT(totals.cpu_time, std::chrono::seconds(5))
+            << threads << " threads";
+        EXPECT_LT(totals.time, std::chrono::seconds(20))
+            << threads << " threads";
+    }
+    Threads.set_count(1);
+}
+
+// CPU burnt while pondering is not charged: the budget starts at ponderhit,
+// the way the UCI loop arms it
+TEST_F(SearchLimitsTest, CpuTimeStartsAtPonderhit) {
+    Threads.set_count(1);
+    tt::TT.clear();
+
+    SearchLimits limits;
+    limits.max_time = std::chrono::hours(24);
+    limits.cpu_time = std::chrono::milliseconds(100);
+    limits.ponder = true;
+
+    std::atomic<bool> done{false};
+    SearchEngine::clear_stop();
+    std::thread searcher([&] {
+        Threads.run(pos, limits);
+        done = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    const bool stopped_while_pondering = done;
+
+    SearchEngine::ponderhit(std::chrono::hours(24));
+    SearchEngine::set_cpu_budget(limits.cpu_time);
+    const auto hit = std::chrono::steady_clock::now();
+    for (std::int32_t i = 0; i < 200 && !done; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    const bool stopped_after_hit = done;
+    if (!done) {
+        SearchEngine::stop();
+    }
+    searcher.join();
+
+    EXPECT_FALSE(stopped_while_pondering);
+    EXPECT_TRUE(stopped_after_hit);
+    EXPECT_LT(std::chrono::steady_clock::now() - hit, std::chrono::seconds(10));
+}
+
+}  // namespace
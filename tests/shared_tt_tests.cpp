@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "search_engine.h"
+#include "test_common.h"
+#include "tt.h"
+
+using namespace KhaosChess;
+
+namespace {
+
+// Shared-memory transposition tables. These live in their own binary
+// because they fork: a child may only touch the search, never the
+// ThreadPool, and no pool threads may exist at fork time.
+class SharedTTTest : public ::testing::Test {
+   protected:
+    static void SetUpTestSuite() {
+        init_engine_once();
+    }
+
+    std::string name = "/khaos-tt-test-" + std::to_string(getpid());
+};
+
+TEST_F(SharedTTTest, AttachedTablesSeeEachOthersStores) {
+    tt::TranspositionTable a, b;
+    std::string error;
+    ASSERT_TRUE(a.attach_shared(name, 2, error)) << error;
+    ASSERT_TRUE(b.attach_shared(name, 16, error)) << error;
+
+    // The second attach adopts the size the creator chose
+    EXPECT_EQ(b.size(), a.size());
+    EXPECT_TRUE(a.is_shared() && b.is_shared());
+
+    const BITBOARD key = 0x0BADC0FFEE0DDF00ULL;
+    a.store(key, 123, 7, tt::Flag::F_EXACT, Move(E2, E4), 45);
+
+    bool found = false;
+    tt::TTData d = b.probe(key, found);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(d.score, 123);
+    EXPECT_EQ(d.eval, 45);
+    EXPECT_EQ(d.move, Move(E2, E4));
+}
+
+TEST_F(SharedTTTest, LastDetachRemovesTheSegment) {
+    {
+        tt::TranspositionTable a;
+        std::string error;
+        ASSERT_TRUE(a.attach_shared(name, 1, error)) << error;
+        a.store(1, 1, 1, tt::Flag::F_EXACT, Move(E2, E4));
+    }
+
+    // A fresh attach creates a new, empty segment
+    tt::TranspositionTable b;
+    std::string error;
+    ASSERT_TRUE(b.attach_shared(name, 1, error)) << error;
+    bool found = true;
+    b.probe(1, found);
+    EXPECT_FALSE(found);
+}
+
+// Runs a fixed-depth search in a child process on the global table
+// attached to `name`; returns the nodes it needed and its wall time
+struct ChildResult {
+    std::uint64_t nodes = 0;
+    std::int64_t ms = 0;
+};
+
+ChildResult search_in_child(const std::string& name, std::int32_t depth) {
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        std::string error;
+        ChildResult r;
+        if (tt::TT.attach_shared(name, 16, error)) {
+            Position pos;
+            MoveInfo mi{};
+            pos.set(kKiwipete, &mi);
+
+            SearchEngine engine(pos);
+            engine.set_max_time(std::chrono::milliseconds(600000));
+            SearchInfo info;
+
+            auto start = std::chrono::steady_clock::now();
+            SearchEngine::clear_stop();
+            tt::TT.new_search();
+            engine.search(depth, info);
+            r.ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+            r.nodes = info.nodes + info.q_nodes;
+        }
+        ssize_t written = write(fds[1], &r, sizeof(r));
+        std::exit(written == sizeof(r) ? 0 : 1);  // detaches via ~TT
+    }
+
+    close(fds[1]);
+    ChildResult r;
+    EXPECT_EQ(read(fds[0], &r, sizeof(r)), static_cast<ssize_t>(sizeof(r)));
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    return r;
+}
+
+// Two processes analyse the same position one after the other; the second
+// one starts from everything the first left in the shared table
+TEST_F(SharedTTTest, SecondProcessReachesDepthFaster) {
+    // Keep the segment alive between the two children
+    tt::TranspositionTable keeper;
+    std::string error;
+    ASSERT_TRUE(keeper.attach_shared(name, 16, error)) << error;
+
+    constexpr std::int32_t kDepth = 12;
+    ChildResult first = search_in_child(name, kDepth);
+    ChildResult second = search_in_child(name, kDepth);
+
+    std::cout << "[ SHARED   ] depth " << kDepth << ": first process "
+              << first.nodes << " nodes in " << first.ms
+              << " ms, second process " << second.nodes << " nodes in "
+              << second.ms << " ms\n";
+    RecordProperty("first_ms", static_cast<int>(first.ms));
+    RecordProperty("second_ms", static_cast<int>(second.ms));
+
+    ASSERT_GT(first.nodes, 0u);
+    EXPECT_LT(second.nodes, first.nodes / 2);
+}
+
+}  // namespace
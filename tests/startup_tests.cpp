@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "bitbase.h"
+#include "test_common.h"
+
+using namespace KhaosChess;
+
+namespace {
+
+// Raw copy of a table, to compare it byte for byte after regenerating
+template <typename T>
+std::vector<unsigned char> snapshot(const T& table) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&table);
+    return std::vector<unsigned char>(bytes, bytes + sizeof(table));
+}
+
+template <typename T>
+bool unchanged(const T& table, const std::vector<unsigned char>& before) {
+    return std::memcmp(&table, before.data(), sizeof(table)) == 0;
+}
+
+// The startup tables, whether embedded at build time or computed by init(),
+// must be exactly what generating them from scratch gives
+class StartupTest : public ::testing::Test {
+   protected:
+    static void SetUpTestSuite() { init_engine_once(); }
+};
+
+TEST_F(StartupTest, TablesMatchFreshGeneration) {
+    const auto distance = snapshot(square_distance);
+    const auto between = snapshot(between_points_bb);
+    const auto lines = snapshot(full_line_bb);
+    const auto pseudo = snapshot(pseudo_attacks);
+    const auto pawns = snapshot(pawn_attacks);
+    const auto sliders = snapshot(mSliderAttacks);
+    const auto bitbase = snapshot(BitBase::BITBASE);
+    const auto psq = snapshot(Zobrist::psq);
+    const auto ep = snapshot(Zobrist::en_passant);
+    const auto castling = snapshot(Zobrist::castling);
+    const BITBOARD side = Zobrist::side;
+
+    Bitboards::generate();
+    BitBase::generate();
+    Zobrist::generate();
+
+    EXPECT_TRUE(unchanged(square_distance, distance));
+    EXPECT_TRUE(unchanged(between_points_bb, between));
+    EXPECT_TRUE(unchanged(full_line_bb, lines));
+    EXPECT_TRUE(unchanged(pseudo_attacks, pseudo));
+    EXPECT_TRUE(unchanged(pawn_attacks, pawns));
+    EXPECT_TRUE(unchanged(mSliderAttacks, sliders));
+    EXPECT_TRUE(unchanged(BitBase::BITBASE, bitbase));
+    EXPECT_TRUE(unchanged(Zobrist::psq, psq));
+    EXPECT_TRUE(unchanged(Zobrist::en_passant, ep));
+    EXPECT_TRUE(unchanged(Zobrist::castling, castling));
+    EXPECT_EQ(Zobrist::side, side);
+}
+
+// What a launch pays for the tables: init() as main() calls it, against
+// computing everything from scratch. No speed assertion, like the other
+// benchmarks; the numbers are printed and recorded for comparison.
+TEST_F(StartupTest, StartupBenchmark) {
+    using Clock = std::chrono::steady_clock;
+    const auto ms = [](Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+
+    constexpr int RUNS = 5;
+    Clock::duration init{}, generate{};
+    for (int i = 0; i < RUNS; ++i) {
+        auto start = Clock::now();
+        Bitboards::init();
+        BitBase::init();
+        Zobrist::init();
+        init += Clock::now() - start;
+
+        start = Clock::now();
+        Bitboards::generate();
+        BitBase::generate();
+        Zobrist::generate();
+        generate += Clock::now() - start;
+    }
+
+    std::cout << "[ STARTUP  ] tables "
+#if defined(KHAOS_EMBEDDED_TABLES)
+              << "embedded"
+#else
+              << "computed at startup"
+#endif
+              << ": init " << ms(init / RUNS) << " ms, computing them "
+              << ms(generate / RUNS) << " ms\n";
+}
+
+}  // namespace
@@ -17,6 +17,7 @@ inline void init_engine_once() {
         BitBase::init();
         Endgames::init();
         Zobrist::init();
+        PSQ::init();
         return true;
     }();
     (void)initialized;
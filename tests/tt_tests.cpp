@@ -0,0 +1,466 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "random.h"
+#include "score.h"
+#include "test_common.h"
+#include "tt.h"
+#include "zobrist.h"
+
+using namespace KhaosChess;
+
+namespace {
+
+// Everything a store writes is derived from the key, so any hit whose
+// payload does not match its key must be a torn or crossed entry
+Value score_for(BITBOARD key) {
+    return static_cast<Value>(key % 200001) - 100000;
+}
+Move move_for(BITBOARD key) {
+    return Move(static_cast<std::uint16_t>((key >> 16) | 1));
+}
+std::int32_t depth_for(BITBOARD key) {
+    return static_cast<std::int32_t>((key >> 40) % 60);
+}
+tt::Flag flag_for(BITBOARD key) {
+    return static_cast<tt::Flag>((key >> 48) % 3);
+}
+
+class TTTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        table.resize(1);
+        table.clear();
+    }
+
+    tt::TranspositionTable table;
+};
+
+TEST_F(TTTest, MissOnEmptyTable) {
+    bool found = true;
+    tt::TTData d = table.probe(0x123456789ABCDEFULL, found);
+
+    EXPECT_FALSE(found);
+    EXPECT_EQ(d.depth, -1);
+}
+
+TEST_F(TTTest, StoreThenProbeRoundTrips) {
+    const BITBOARD key = 0xDEADBEEFCAFEF00DULL;
+    table.store(key, -31337, 17, tt::Flag::F_LOWER_BOUND, Move(E2, E4));
+
+    bool found = false;
+    tt::TTData d = table.probe(key, found);
+
+    ASSERT_TRUE(found);
+    EXPECT_EQ(d.score, -31337);
+    EXPECT_EQ(d.move, Move(E2, E4));
+    EXPECT_EQ(d.depth, 17);
+    EXPECT_EQ(d.flag(), tt::Flag::F_LOWER_BOUND);
+}
+
+// A key that shares the cluster and the low 16 key bits would pass a
+// 16-bit check; the 32-bit one refuses it, eval-only entries included
+TEST_F(TTTest, CollidingKeysMiss) {
+    const BITBOARD key = 0x0123456789ABCDEFULL;
+    const BITBOARD other = key + (BITBOARD(1) << 16);
+    ASSERT_EQ(table.cluster_index(other), table.cluster_index(key));
+
+    // What negamax stores when it only has the static eval
+    table.store(other, VALUE_NONE, -1, tt::Flag::F_NONE, Move::invalid_move(),
+                40);
+
+    bool found = true;
+    table.probe(key, found);
+    EXPECT_FALSE(found);
+
+    table.store(other, 100, 5, tt::Flag::F_UPPER_BOUND, Move::invalid_move(),
+                40);
+    table.probe(key, found);
+    EXPECT_FALSE(found);
+
+    table.probe(other, found);
+    EXPECT_TRUE(found);
+}
+
+// The position-checked probe also drops a hit whose move or eval cannot
+// belong to the position
+TEST_F(TTTest, PositionProbeRejectsForeignHits) {
+    init_engine_once();
+    Position pos;
+    MoveInfo mi{};
+    pos.set(kStartPos, &mi);
+
+    bool found = false;
+    table.store(pos.key(), 100, 5, tt::Flag::F_EXACT, Move(E7, E5), 40);
+    table.probe(pos.key(), found);
+    ASSERT_TRUE(found);
+    table.probe(pos, found);
+    EXPECT_FALSE(found);
+
+    table.clear();
+    table.store(pos.key(), 100, 5, tt::Flag::F_EXACT, Move::invalid_move(),
+                VALUE_MATE + 5);
+    table.probe(pos, found);
+    EXPECT_FALSE(found);
+
+    table.clear();
+    table.store(pos.key(), 100, 5, tt::Flag::F_EXACT, Move(E2, E4), 40);
+    tt::TTData d = table.probe(pos, found);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(d.move, Move(E2, E4));
+    EXPECT_EQ(d.eval, 40);
+}
+
+TEST_F(TTTest, MovelessUpdateKeepsMoveAndEval) {
+    const BITBOARD key = 0x0123456789ABCDEFULL;
+    table.store(key, 10, 5, tt::Flag::F_EXACT, Move(G1, F3), -42);
+    table.store(key, 20, 6, tt::Flag::F_UPPER_BOUND, Move::invalid_move());
+
+    bool found = false;
+    tt::TTData d = table.probe(key, found);
+
+    ASSERT_TRUE(found);
+    EXPECT_EQ(d.score, 20);
+    EXPECT_EQ(d.move, Move(G1, F3));
+    EXPECT_EQ(d.eval, -42);
+}
+
+TEST_F(TTTest, ExtremeScoresRoundTrip) {
+    const BITBOARD key = 0xFEDCBA9876543210ULL;
+    for (Value v : {VALUE_MATE, -VALUE_MATE, VALUE_INFINITE, -VALUE_INFINITE,
+                    VALUE_NONE, Value(0), Value(-1)}) {
+        table.store(key, v, 0, tt::Flag::F_EXACT, Move(E2, E4), -v);
+
+        bool found = false;
+        tt::TTData d = table.probe(key, found);
+
+        ASSERT_TRUE(found);
+        EXPECT_EQ(d.score, v);
+        EXPECT_EQ(d.eval, -v);
+    }
+}
+
+TEST_F(TTTest, UsesExactlyTheRequestedMegabytes) {
+    for (std::size_t mb : {1, 3, 5, 48}) {
+        table.resize(mb);
+        EXPECT_EQ(table.size() * sizeof(tt::Cluster), mb * 1024 * 1024);
+    }
+}
+
+TEST_F(TTTest, IndexIsInRangeAndUniform) {
+    table.resize(3);  // 49152 clusters, not a power of two
+    const std::size_t count = table.size();
+
+    EXPECT_EQ(table.cluster_index(0), 0u);
+    EXPECT_EQ(table.cluster_index(~BITBOARD(0)), count - 1);
+
+    // Random keys should spread evenly: bucket the indices into 16 ranges
+    // and allow 3% deviation from the expected count per range
+    constexpr int kBuckets = 16;
+    constexpr int kSamples = 1 << 20;
+    std::vector<int> hist(kBuckets, 0);
+
+    PRNG rng(42);
+    for (int i = 0; i < kSamples; i++) {
+        std::size_t idx = table.cluster_index(rng.rand<BITBOARD>());
+        ASSERT_LT(idx, count);
+        hist[idx * kBuckets / count]++;
+    }
+
+    const double expected = double(kSamples) / kBuckets;
+    for (int b = 0; b < kBuckets; b++) {
+        EXPECT_NEAR(hist[b], expected, expected * 0.03) << "bucket " << b;
+    }
+}
+
+TEST_F(TTTest, HashfullCountsCurrentSearchOnly) {
+    EXPECT_EQ(table.hashfull(), 0);
+
+    // Enough random keys to fill every slot of the sampled clusters
+    PRNG rng(7);
+    for (std::size_t i = 0; i < table.size() * 20; i++) {
+        BITBOARD key = rng.rand<BITBOARD>();
+        table.store(key, 0, 1, tt::Flag::F_EXACT, move_for(key));
+    }
+    EXPECT_EQ(table.hashfull(), 1000);
+
+    table.new_search();
+    EXPECT_EQ(table.hashfull(), 0);
+}
+
+TEST_F(TTTest, StatsCountProbesAndStores) {
+    table.set_stats(true);
+    table.new_search();
+
+    const BITBOARD key = 0x1111222233334444ULL;
+    bool found = false;
+    table.probe(key, found);
+    table.store(key, 1, 3, tt::Flag::F_EXACT, Move(E2, E4));
+    table.probe(key, found);
+    table.store(key, 2, 4, tt::Flag::F_EXACT, Move(E2, E4));
+
+    tt::TTStats s = table.stats();
+    EXPECT_EQ(s.probes, 2u);
+    EXPECT_EQ(s.hits, 1u);
+    EXPECT_EQ(s.fills, 1u);
+    EXPECT_EQ(s.updates, 1u);
+    EXPECT_EQ(s.evict_age + s.evict_depth + s.collisions, 0u);
+}
+
+// Saved tables: the load maps the file, so the entries must come back
+// bit-exact, and files the current build cannot interpret must be refused
+class TTFileTest : public TTTest {
+   protected:
+    std::string path = ::testing::TempDir() + "khaos_tt_test.hash";
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    // Overwrite `size` bytes of the saved file at `offset`
+    void patch(long offset, const void* bytes, std::size_t size) {
+        std::FILE* f = std::fopen(path.c_str(), "r+b");
+        ASSERT_NE(f, nullptr);
+        std::fseek(f, offset, SEEK_SET);
+        std::fwrite(bytes, 1, size, f);
+        std::fclose(f);
+    }
+};
+
+TEST_F(TTFileTest, SaveThenLoadRestoresEntries) {
+    table.resize(3);
+    for (BITBOARD k = 1; k <= 1000; k++) {
+        BITBOARD key = k * 0x9E3779B97F4A7C15ULL;
+        table.store(key, score_for(key), depth_for(key), flag_for(key),
+                    move_for(key), -score_for(key));
+    }
+
+    std::string error;
+    ASSERT_TRUE(table.save(path, error)) << error;
+
+    tt::TranspositionTable loaded;
+    loaded.resize(1);
+    ASSERT_TRUE(loaded.load(path, error)) << error;
+    EXPECT_EQ(loaded.size(), table.size());
+
+    for (BITBOARD k = 1; k <= 1000; k++) {
+        BITBOARD key = k * 0x9E3779B97F4A7C15ULL;
+        bool found_saved = false, found_loaded = false;
+        tt::TTData a = table.probe(key, found_saved);
+        tt::TTData b = loaded.probe(key, found_loaded);
+
+        ASSERT_EQ(found_saved, found_loaded);
+        if (found_loaded) {
+            EXPECT_EQ(b.score, a.score);
+            EXPECT_EQ(b.eval, a.eval);
+            EXPECT_EQ(b.move, a.move);
+            EXPECT_EQ(b.depth, a.depth);
+        }
+    }
+
+    // The mapping is private: searching the loaded table leaves the file
+    // as it was
+    loaded.clear();
+    tt::TranspositionTable again;
+    ASSERT_TRUE(again.load(path, error)) << error;
+    bool found = false;
+    again.probe(1 * 0x9E3779B97F4A7C15ULL, found);
+    EXPECT_TRUE(found);
+}
+
+TEST_F(TTFileTest, RejectsOtherFormatVersion) {
+    std::string error;
+    ASSERT_TRUE(table.save(path, error)) << error;
+
+    const std::uint32_t version = 0xFFFF;
+    patch(8, &version, sizeof(version));  // right after the magic
+
+    EXPECT_FALSE(table.load(path, error));
+    EXPECT_NE(error.find("version"), std::string::npos) << error;
+}
+
+TEST_F(TTFileTest, RejectsOtherZobristSeed) {
+    std::string error;
+    ASSERT_TRUE(table.save(path, error)) << error;
+
+    const std::uint64_t seed = Zobrist::SEED + 1;
+    patch(16, &seed, sizeof(seed));  // magic, version, cluster size
+
+    EXPECT_FALSE(table.load(path, error));
+    EXPECT_NE(error.find("Zobrist"), std::string::npos) << error;
+}
+
+// A cluster count whose byte size wraps around 64 bits to the real one
+// must not get past the size check
+TEST_F(TTFileTest, RejectsWrappedClusterCount) {
+    std::string error;
+    ASSERT_TRUE(table.save(path, error)) << error;
+
+    // 2^58 clusters of 64 bytes are 2^64 bytes, i.e. zero
+    const std::uint64_t count = table.size() + (std::uint64_t(1) << 58);
+    patch(24, &count, sizeof(count));  // ... Zobrist seed
+
+    EXPECT_FALSE(table.load(path, error));
+    EXPECT_NE(error.find("size"), std::string::npos) << error;
+}
+
+TEST_F(TTFileTest, RejectsMissingAndTruncatedFiles) {
+    std::string error;
+    EXPECT_FALSE(table.load(path + ".missing", error));
+
+    ASSERT_TRUE(table.save(path, error)) << error;
+    std::FILE* f = std::fopen(path.c_str(), "ab");
+    std::fputc(0, f);
+    std::fclose(f);
+    EXPECT_FALSE(table.load(path, error));
+
+    // A rejected load leaves the table usable
+    table.store(42, 1, 1, tt::Flag::F_EXACT, Move(E2, E4));
+    bool found = false;
+    table.probe(42, found);
+    EXPECT_TRUE(found);
+}
+
+// Many threads store and probe a small key set that maps onto a handful of
+// clusters, so entries are overwritten while other threads read them. With
+// the XOR verification a torn entry is reported as a miss, never as a hit
+// carrying another position's data.
+TEST_F(TTTest, ConcurrentHitsAreNeverCorrupted) {
+    constexpr int kThreads = 8;
+    constexpr int kIterations = 200000;
+    constexpr int kKeys = 256;
+
+    // The cluster comes from the high bits of the key; keys that only
+    // differ below bit 48 crowd into four clusters. Their low 16 bits, the
+    // part an entry keeps, are all distinct, so a wrong hit can only be a
+    // torn entry and never a partial-key collision
+    std::vector<BITBOARD> keys(kKeys);
+    PRNG rng(20240611);
+    for (int i = 0; i < kKeys; i++) {
+        keys[i] = ((rng.rand<BITBOARD>() & 3) << 60) |
+                  (rng.rand<BITBOARD>() & ((BITBOARD(1) << 48) - 0x10000)) |
+                  BITBOARD(i);
+    }
+
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> corrupted{0};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; t++) {
+        workers.emplace_back([&, t] {
+            PRNG local(1000 + t);
+            std::uint64_t my_hits = 0, my_corrupted = 0;
+
+            for (int i = 0; i < kIterations; i++) {
+                BITBOARD key = keys[local.rand<std::uint64_t>() % kKeys];
+
+                if (i & 1) {
+                    table.store(key, score_for(key), depth_for(key),
+                                flag_for(key), move_for(key));
+                    continue;
+                }
+
+                bool found = false;
+                tt::TTData d = table.probe(key, found);
+                if (!found) {
+                    continue;
+                }
+
+                my_hits++;
+                if (d.score != score_for(key) || d.move != move_for(key) ||
+                    d.depth != depth_for(key) || d.flag() != flag_for(key)) {
+                    my_corrupted++;
+                }
+            }
+
+            hits += my_hits;
+            corrupted += my_corrupted;
+        });
+    }
+
+    for (std::thread& w : workers) {
+        w.join();
+    }
+
+    EXPECT_GT(hits.load(), 0u);
+    EXPECT_EQ(corrupted.load(), 0u);
+}
+
+// Fill-rate benchmark: how many probes hit at a fixed Hash budget. A
+// working set of keys twice the size of what 16-byte entries could hold is
+// probed uniformly at random, storing on every miss, so the steady-state hit
+// rate tracks how many entries actually fit in the table. Like the perft
+// benchmarks this asserts nothing about the rate; it is printed and recorded
+// for comparison between table layouts.
+class TTFillBenchmark : public ::testing::Test {
+   protected:
+    // SplitMix64: a cheap bijective mix, so key i is reproducible without
+    // keeping the working set in memory
+    static BITBOARD key_of(std::uint64_t i) {
+        BITBOARD z = i + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static void benchmark(std::size_t mb) {
+        static tt::TranspositionTable table;
+        table.resize(mb);
+
+        const std::uint64_t working_set = mb * 1024 * 1024 / 8;
+        PRNG rng(mb);
+
+        std::uint64_t probes = 0, hits = 0, false_hits = 0;
+        const auto start = std::chrono::steady_clock::now();
+
+        // First pass warms the table up, the second one is measured
+        for (int pass = 0; pass < 2; pass++) {
+            for (std::uint64_t n = 0; n < working_set; n++) {
+                BITBOARD key = key_of(rng.rand<std::uint64_t>() % working_set);
+
+                bool found = false;
+                tt::TTData d = table.probe(key, found);
+                if (pass == 1) {
+                    probes++;
+                    hits += found && d.score == score_for(key);
+                    false_hits += found && d.score != score_for(key);
+                }
+                if (!found) {
+                    table.store(key, score_for(key), depth_for(key) % 16,
+                                tt::Flag::F_EXACT, move_for(key));
+                }
+            }
+        }
+
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+        const double rate = 100.0 * hits / probes;
+
+        std::cout << "[ TT FILL  ] " << mb << " MB: " << rate
+                  << "% hit rate, " << false_hits << " false hits ("
+                  << elapsed.count() << " ms)\n";
+        RecordProperty("hit_rate_x100", static_cast<int>(rate * 100));
+        EXPECT_GT(hits, 0u);
+    }
+};
+
+TEST_F(TTFillBenchmark, Hash16MB) {
+    benchmark(16);
+}
+
+TEST_F(TTFillBenchmark, Hash64MB) {
+    benchmark(64);
+}
+
+TEST_F(TTFillBenchmark, Hash256MB) {
+    benchmark(256);
+}
+
+}  // namespace
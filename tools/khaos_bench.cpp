@@ -0,0 +1,376 @@
+// Microbenchmarks for the engine's hot paths: legal move generation,
+// do/undo, SEE, evaluation (from scratch and through the search's pawn and
+// material tables), TT probe/store, slider attacks and draw detection,
+// each timed over the same corpus of positions and reported in ns/op.
+// Where "bench" gives one number for the whole search, this says which
+// part of it moved.
+//
+// usage: khaos_bench [--json] [--positions FILE] [--filter PREFIX]
+//
+// The default corpus is every position of a short seeded random game from
+// each "bench" position, with its history, so is_draw has moves to look
+// back over. --positions reads one FEN per line instead (anything after
+// the sixth field, such as an EPD result, is ignored). --json prints the
+// results as one JSON object, for tracking them across commits.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "bitboard.h"
+#include "endgame.h"
+#include "movegen.h"
+#include "position.h"
+#include "random.h"
+#include "score.h"
+#include "tt.h"
+#include "zobrist.h"
+
+using namespace KhaosChess;
+
+namespace {
+
+constexpr std::int32_t GAME_PLIES = 24;
+constexpr std::int32_t SAMPLES = 5;
+constexpr std::chrono::milliseconds SAMPLE_TIME{50};
+constexpr std::size_t TT_MB = 16;
+
+// A position together with the moves that led to it
+struct Node {
+    std::deque<MoveInfo> infos;
+    Position pos;
+    std::vector<Move> moves;  // its legal moves, for the per-move benchmarks
+};
+
+std::vector<std::unique_ptr<Node>> corpus;
+
+// Keeps results alive so the compiler cannot drop the work behind them
+volatile std::uint64_t sink;
+
+std::unique_ptr<Node> make_node(const std::string& fen,
+                                const std::vector<Move>& line) {
+    auto node = std::make_unique<Node>();
+    node->infos.emplace_back();
+    node->pos.set(fen, &node->infos.back());
+    for (Move m : line) {
+        node->infos.emplace_back();
+        node->pos.do_move(m, node->infos.back());
+    }
+    for (const auto& m : MoveList<GT_LEGAL>(node->pos)) {
+        node->moves.push_back(m);
+    }
+    return node;
+}
+
+void build_game_corpus() {
+    PRNG rng(1070372);
+    for (const std::string& fen : BENCH_FENS) {
+        Position pos;
+        std::deque<MoveInfo> infos(1);
+        pos.set(fen, &infos.back());
+
+        std::vector<Move> line;
+        corpus.push_back(make_node(fen, line));
+        for (std::int32_t ply = 0; ply < GAME_PLIES; ++ply) {
+            MoveList<GT_LEGAL> legal(pos);
+            if (legal.size() == 0) {
+                break;
+            }
+            std::size_t pick = rng.rand<std::uint64_t>() % legal.size();
+            Move m = *(legal.begin() + pick);
+            infos.emplace_back();
+            pos.do_move(m, infos.back());
+            line.push_back(m);
+            corpus.push_back(make_node(fen, line));
+        }
+    }
+}
+
+bool load_corpus(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string field, fen;
+        for (std::int32_t i = 0; i < 6 && fields >> field; ++i) {
+            if (field.find_first_of(";[\"") != std::string::npos) {
+                break;
+            }
+            fen += (i ? " " : "") + field;
+        }
+        if (!fen.empty()) {
+            corpus.push_back(make_node(fen, {}));
+        }
+    }
+    return !corpus.empty();
+}
+
+struct Result {
+    std::string name;
+    double ns_per_op;
+    std::uint64_t ops;  // operations in one pass over the corpus
+};
+
+// One pass runs the operation over the whole corpus and returns how many
+// it did. Passes are repeated to fill SAMPLE_TIME, and the fastest of
+// SAMPLES such samples is reported: the others only add scheduler noise.
+template <typename Pass>
+Result measure(const std::string& name, Pass&& pass) {
+    using Clock = std::chrono::steady_clock;
+
+    auto start = Clock::now();
+    const std::uint64_t ops = pass();
+    const auto once = Clock::now() - start;
+
+    const std::int64_t repeats = std::max<std::int64_t>(
+        1, SAMPLE_TIME / std::max<Clock::duration>(once, Clock::duration(1)));
+
+    double best = 0;
+    for (std::int32_t s = 0; s < SAMPLES; ++s) {
+        start = Clock::now();
+        for (std::int64_t r = 0; r < repeats; ++r) {
+            pass();
+        }
+        const double ns =
+            std::chrono::duration<double, std::nano>(Clock::now() - start)
+                .count() /
+            (static_cast<double>(ops) * repeats);
+        best = s ? std::min(best, ns) : ns;
+    }
+
+    return {name, best, ops};
+}
+
+std::uint64_t movegen_legal() {
+    std::uint64_t ops = 0, total = 0;
+    ScoredMoves moves[MAX_MOVES];
+    for (auto& node : corpus) {
+        total += generate_moves<GT_LEGAL>(node->pos, moves) - moves;
+        ++ops;
+    }
+    sink = total;
+    return ops;
+}
+
+std::uint64_t do_undo() {
+    std::uint64_t ops = 0, keys = 0;
+    for (auto& node : corpus) {
+        for (Move m : node->moves) {
+            MoveInfo mi;
+            node->pos.do_move(m, mi);
+            keys += node->pos.key();
+            node->pos.undo_move(m);
+        }
+        ops += node->moves.size();
+    }
+    sink = keys;
+    return ops;
+}
+
+std::uint64_t see_ge() {
+    std::uint64_t ops = 0, good = 0;
+    for (auto& node : corpus) {
+        for (Move m : node->moves) {
+            good += node->pos.see_ge(m, 0);
+        }
+        ops += node->moves.size();
+    }
+    sink = good;
+    return ops;
+}
+
+// Without tables every term is computed from the board; with them the
+// pawn and material terms come from the caches, as in the search
+std::uint64_t evaluate(PawnTable* pawns, MaterialTable* materials) {
+    std::uint64_t ops = 0;
+    std::int64_t total = 0;
+    for (auto& node : corpus) {
+        total += Scorer<SC_ALL>(pawns, materials).get_score(node->pos);
+        ++ops;
+    }
+    sink = static_cast<std::uint64_t>(total);
+    return ops;
+}
+
+// The keys of every corpus position and its children: more than the
+// corpus alone, so they spread over the table as a search's keys do
+std::vector<BITBOARD> tt_keys() {
+    std::vector<BITBOARD> keys;
+    for (auto& node : corpus) {
+        keys.push_back(node->pos.key());
+        for (Move m : node->moves) {
+            keys.push_back(node->pos.key_after(m));
+        }
+    }
+    return keys;
+}
+
+std::uint64_t tt_store(const std::vector<BITBOARD>& keys) {
+    std::int32_t depth = 0;
+    for (BITBOARD key : keys) {
+        tt::TT.store(key, static_cast<Value>(key & 0xFF), depth++ & 15,
+                     tt::Flag::F_EXACT, Move::invalid_move());
+    }
+    return keys.size();
+}
+
+std::uint64_t tt_probe(const std::vector<BITBOARD>& keys) {
+    std::uint64_t hits = 0;
+    for (BITBOARD key : keys) {
+        bool found;
+        tt::TT.probe(key, found);
+        hits += found;
+    }
+    sink = hits;
+    return keys.size();
+}
+
+// Bishop and rook attacks from every square, on each position's occupancy
+std::uint64_t slider_attacks() {
+    std::uint64_t ops = 0;
+    BITBOARD total = 0;
+    for (auto& node : corpus) {
+        BITBOARD occupied = node->pos.get_all_pieces_bb();
+        for (Square s = A8; s <= H1; ++s) {
+            total ^= attacks_bb_by<BISHOP>(s, occupied);
+            total ^= attacks_bb_by<ROOK>(s, occupied);
+        }
+        ops += 2 * SQUARE_TOTAL;
+    }
+    sink = total;
+    return ops;
+}
+
+std::uint64_t is_draw() {
+    std::uint64_t ops = 0, draws = 0;
+    for (auto& node : corpus) {
+        draws += node->pos.is_draw();
+        ++ops;
+    }
+    sink = draws;
+    return ops;
+}
+
+void print_text(const std::vector<Result>& results) {
+    std::cout << corpus.size() << " positions\n\n";
+    for (const Result& r : results) {
+        char line[96];
+        std::snprintf(line, sizeof(line), "%-20s %10.2f ns/op  %10llu ops\n",
+                      r.name.c_str(), r.ns_per_op,
+                      static_cast<unsigned long long>(r.ops));
+        std::cout << line;
+    }
+}
+
+void print_json(const std::vector<Result>& results) {
+    std::cout << "{\n  \"positions\": " << corpus.size()
+              << ",\n  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        char entry[160];
+        std::snprintf(entry, sizeof(entry),
+                      "%s\n    {\"name\": \"%s\", \"ns_per_op\": %.3f, "
+                      "\"ops\": %llu}",
+                      i ? "," : "", results[i].name.c_str(),
+                      results[i].ns_per_op,
+                      static_cast<unsigned long long>(results[i].ops));
+        std::cout << entry;
+    }
+    std::cout << "\n  ]\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    std::string positions, filter;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--positions" && i + 1 < argc) {
+            positions = argv[++i];
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            std::cerr << "usage: khaos_bench [--json] [--positions FILE] "
+                         "[--filter PREFIX]\n";
+            return 1;
+        }
+    }
+
+    Bitboards::init();
+    BitBase::init();
+    Endgames::init();
+    Zobrist::init();
+    PSQ::init();
+    tt::TT.resize(TT_MB);
+
+    if (positions.empty()) {
+        build_game_corpus();
+    } else if (!load_corpus(positions)) {
+        std::cerr << "khaos_bench: no positions in " << positions << "\n";
+        return 1;
+    }
+
+    const std::vector<BITBOARD> keys = tt_keys();
+    const auto wanted = [&](const char* name) {
+        return std::string(name).rfind(filter, 0) == 0;
+    };
+
+    std::vector<Result> results;
+    if (wanted("movegen_legal")) {
+        results.push_back(measure("movegen_legal", movegen_legal));
+    }
+    if (wanted("do_undo")) {
+        results.push_back(measure("do_undo", do_undo));
+    }
+    if (wanted("see_ge")) {
+        results.push_back(measure("see_ge", see_ge));
+    }
+    if (wanted("evaluate")) {
+        results.push_back(
+            measure("evaluate", [] { return evaluate(nullptr, nullptr); }));
+    }
+    // One pair of tables per benchmark, warmed by the first pass like a
+    // search's are by the positions it keeps returning to
+    if (wanted("evaluate_tables")) {
+        auto pawns = std::make_unique<PawnTable>();
+        auto materials = std::make_unique<MaterialTable>();
+        results.push_back(measure("evaluate_tables", [&] {
+            return evaluate(pawns.get(), materials.get());
+        }));
+    }
+    if (wanted("tt_store")) {
+        results.push_back(measure("tt_store", [&] { return tt_store(keys); }));
+    }
+    if (wanted("tt_probe")) {
+        tt_store(keys);
+        results.push_back(measure("tt_probe", [&] { return tt_probe(keys); }));
+    }
+    if (wanted("slider_attacks")) {
+        results.push_back(measure("slider_attacks", slider_attacks));
+    }
+    if (wanted("is_draw")) {
+        results.push_back(measure("is_draw", is_draw));
+    }
+
+    if (json) {
+        print_json(results);
+    } else {
+        print_text(results);
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+// Standalone perft, for move generator regression runs without a UCI
+// session. Prints the per-move divide, the total and the speed.
+//
+// usage: perft <depth> [fen] [--threads N] [--hash MB] [--no-bulk]
+//
+// The FEN defaults to the start position. --no-bulk makes every leaf move,
+// like the reference perft the tests check against.
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "bitboard.h"
+#include "perft.h"
+#include "position.h"
+#include "zobrist.h"
+
+using namespace KhaosChess;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: perft <depth> [fen] [--threads N] [--hash MB] "
+                     "[--no-bulk]\n";
+        return 1;
+    }
+
+    std::int32_t depth = std::atoi(argv[1]);
+    std::string fen = START_FEN;
+    PerftOptions options;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (arg == "--hash" && i + 1 < argc) {
+            options.hash_mb = static_cast<std::size_t>(std::atoi(argv[++i]));
+        } else if (arg == "--no-bulk") {
+            options.bulk = false;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "perft: unknown option " << arg << "\n";
+            return 1;
+        } else {
+            fen = arg;
+        }
+    }
+
+    Bitboards::init();
+    Zobrist::init();
+
+    Position pos;
+    MoveInfo mi{};
+    pos.set(fen, &mi);
+
+    perft_debug(pos, depth, options);
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Build-time table generator. Runs the startup initializers once and writes
+// their results out as C++ initializers, which the engine then compiles in
+// instead of recomputing them on every launch (KHAOS_EMBED_TABLES).
+//
+// usage: tablegen <output-dir>
+//
+// Writes bitboard_tables.inc, bitbase_tables.inc and zobrist_tables.inc;
+// each is #included by the source file that owns the tables.
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bitbase.h"
+#include "bitboard.h"
+#include "zobrist.h"
+
+using namespace KhaosChess;
+
+namespace {
+
+constexpr const char* HEADER =
+    "// Generated by tools/tablegen.cpp at build time. Do not edit.\n";
+
+std::string literal(std::uint64_t v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "0x%" PRIx64 "ULL", v);
+    return buf;
+}
+
+std::string literal(std::uint32_t v) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "0x%" PRIx32 "u", v);
+    return buf;
+}
+
+std::string literal(std::int32_t v) { return std::to_string(v); }
+
+// Writes `data` as a brace-nested initializer for an array of shape `dims`
+template <typename T>
+void write_values(std::ostream& out, const T* data,
+                  const std::vector<std::size_t>& dims, std::size_t dim = 0) {
+    std::size_t stride = 1;
+    for (std::size_t d = dim + 1; d < dims.size(); ++d) {
+        stride *= dims[d];
+    }
+
+    out << "{";
+    if (dim + 1 < dims.size()) {
+        for (std::size_t i = 0; i < dims[dim]; ++i) {
+            out << (i ? ",\n" : "\n");
+            write_values(out, data + i * stride, dims, dim + 1);
+        }
+        out << "\n";
+    } else {
+        constexpr std::size_t PER_LINE = 8;
+        for (std::size_t i = 0; i < dims[dim]; ++i) {
+            out << ((i % PER_LINE) ? ", " : (i ? ",\n" : "\n"))
+                << literal(data[i]);
+        }
+        out << "\n";
+    }
+    out << "}";
+}
+
+template <typename T>
+void write_array(std::ostream& out, const char* decl, const T* data,
+                 const std::vector<std::size_t>& dims) {
+    out << decl << " = ";
+    write_values(out, data, dims);
+    out << ";\n\n";
+}
+
+// The magic constants only; SMagic::attack is aimed at the active slider
+// layout by Bitboards::init()
+void write_magics(std::ostream& out, const char* name, const SMagic* magics) {
+    out << "SMagic " << name << "[SQUARE_TOTAL] = {\n";
+    for (Square s = A8; s <= H1; ++s) {
+        out << "    {nullptr, " << literal(magics[s].mask) << ", "
+            << literal(magics[s].magic) << ", " << magics[s].shift << "},\n";
+    }
+    out << "};\n\n";
+}
+
+bool write_file(const std::string& path, void (*body)(std::ostream&)) {
+    std::ofstream out(path);
+    out << HEADER << "\n";
+    body(out);
+
+    if (!out) {
+        std::cerr << "tablegen: cannot write " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+void bitboard_tables(std::ostream& out) {
+    const std::vector<std::size_t> squares{SQUARE_TOTAL, SQUARE_TOTAL};
+
+    write_array(out, "std::int32_t square_distance[SQUARE_TOTAL][SQUARE_TOTAL]",
+                &square_distance[0][0], squares);
+    write_array(out, "BITBOARD between_points_bb[SQUARE_TOTAL][SQUARE_TOTAL]",
+                &between_points_bb[0][0], squares);
+    write_array(out, "BITBOARD pseudo_attacks[PIECE_TYPE_NB][SQUARE_TOTAL]",
+                &pseudo_attacks[0][0], {PIECE_TYPE_NB, SQUARE_TOTAL});
+    write_array(out, "BITBOARD pawn_attacks[BOTH][SQUARE_TOTAL]",
+                &pawn_attacks[0][0], {BOTH, SQUARE_TOTAL});
+    write_array(out, "BITBOARD full_line_bb[SQUARE_TOTAL][SQUARE_TOTAL]",
+                &full_line_bb[0][0], squares);
+    write_magics(out, "bishop_magic_tbl", bishop_magic_tbl);
+    write_magics(out, "rook_magic_tbl", rook_magic_tbl);
+    // In the layout the build starts in: magic, unless PEXT is forced.
+    // Bitboards::init() reorders it once if it picks PEXT instead
+    write_array(out, "BITBOARD mSliderAttacks[SLIDER_ATTACKS_SIZE]",
+                mSliderAttacks, {SLIDER_ATTACKS_SIZE});
+}
+
+void bitbase_tables(std::ostream& out) {
+    write_array(out, "std::uint32_t BITBASE[MAX_INDEX / 32]", BitBase::BITBASE,
+                {BitBase::MAX_INDEX / 32});
+}
+
+void zobrist_tables(std::ostream& out) {
+    write_array(out, "BITBOARD psq[PIECE_NB][SQUARE_TOTAL]", &Zobrist::psq[0][0],
+                {PIECE_NB, SQUARE_TOTAL});
+    write_array(out, "BITBOARD en_passant[FILE_NB]", Zobrist::en_passant,
+                {FILE_NB});
+    write_array(out, "BITBOARD castling[CASTLING_RIGHT_NB]", Zobrist::castling,
+                {CASTLING_RIGHT_NB});
+    out << "BITBOARD side = " << literal(Zobrist::side) << ";\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: tablegen <output-dir>\n";
+        return 1;
+    }
+
+    Bitboards::generate();
+    BitBase::generate();
+    Zobrist::generate();
+
+    const std::string dir = argv[1];
+    bool ok = write_file(dir + "/bitboard_tables.inc", bitboard_tables) &&
+              write_file(dir + "/bitbase_tables.inc", bitbase_tables) &&
+              write_file(dir + "/zobrist_tables.inc", zobrist_tables);
+
+    return ok ? 0 : 1;
+}
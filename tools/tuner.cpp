@@ -409,6 +409,11 @@ int main(int argc, char* argv[]) {
     BitBase::init();
     Endgames::init();
     Zobrist::init();
+    PSQ::init();
+
+    // Weights change under the loaded positions, so the eval must not
+    // trust their running material + PSQT sums
+    INCREMENTAL_PSQ = false;
 
     size_t limit = argc > 2 ? std::stoul(argv[2]) : 0;
     std::cout << "loaded " << load_dataset(argv[1], limit) << " positions\n";